@@ -0,0 +1,837 @@
+// aparsing_bench: parse cost of getopt and moduleparam on synthetic
+// command lines, as JSON
+//
+// Every workload dimension takes a comma-separated list, and every
+// combination is measured.  Each result gives the time per argument, the
+// allocations per parse and, where perf_event_open is allowed, cycles,
+// instructions and branch misses per argument.  The global getopt_long
+// and getopt_long_only are the host's where the C library has them
+// (glibc elides ours), so they are the baseline for the _r versions.
+// The parameter file loaders read the moduleparam command line from a
+// file, one argument a line with a comment every 16, and also give the
+// throughput in megabytes a second.
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "moduleparam.h"
+
+#ifdef _WIN32
+# include <io.h>
+# include <windows.h>
+#else
+# include <unistd.h>
+#endif
+
+#ifdef __linux__
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+#endif
+
+#ifdef __GLIBC__
+# include <gnu/libc-version.h>
+#endif
+
+// allocations are counted by wrapping the C library's allocator
+#ifdef __GLIBC__
+# define COUNT_ALLOCATIONS 1
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void __libc_free(void *);
+
+static long long allocations;
+
+void *malloc(size_t size)
+{
+    ++allocations;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    ++allocations;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+    ++allocations;
+    return __libc_realloc(p, size);
+}
+
+void free(void *p)
+{
+    __libc_free(p);
+}
+#else
+# define COUNT_ALLOCATIONS 0
+static long long allocations;
+#endif
+
+// ---- workloads ----
+
+#define MAXLIST 16
+
+struct list
+{
+    int n;
+    int v[MAXLIST];
+};
+
+struct workload
+{
+    int options;        // long options defined
+    int args;           // argv elements after the program name
+    int abbrev;         // percent of long options given abbreviated
+    int operands;       // percent of elements that are operands
+    int params;         // moduleparam parameters defined
+    int array;          // elements of each array parameter, 0 for none
+};
+
+static const char *words[] =
+{
+    "add", "all", "alpha", "append", "archive", "build", "by", "cache",
+    "check", "color", "config", "create", "debug", "delete", "dir", "dry",
+    "file", "force", "format", "help", "include", "input", "jobs", "keep",
+    "level", "list", "log", "max", "min", "mode", "name", "no",
+    "output", "path", "prefix", "quiet", "recursive", "run", "size", "sort",
+    "source", "strip", "target", "time", "type", "update", "verbose", "version",
+};
+
+#define NWORDS (int)(sizeof(words) / sizeof(words[0]))
+
+static char short_options[] = "a:bc::d:v";
+
+static unsigned long long rng_state = 88172645463325252ull;
+
+unsigned rnd(void)
+{
+    // xorshift64
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (unsigned)(rng_state >> 32);
+}
+
+// strings that live as long as the workload
+struct pool
+{
+    char **strings;
+    int n, room;
+};
+
+char *pool_add(struct pool *p, const char *s)
+{
+    if (p->n == p->room)
+    {
+        p->room = p->room ? p->room * 2 : 256;
+        p->strings = (char **)realloc(p->strings, p->room * sizeof(char *));
+    }
+    return p->strings[p->n++] = strdup(s);
+}
+
+void pool_free(struct pool *p)
+{
+    while (p->n > 0)
+        free(p->strings[--p->n]);
+    free(p->strings);
+    p->strings = 0;
+    p->room = 0;
+}
+
+struct getopt_fixture
+{
+    struct option *longopts;
+    int *minlen;        // shortest unambiguous abbreviation
+    struct getopt_spec *spec;
+    int argc;
+    char **argv;
+    char **scratch;     // the permuting entry points reorder a copy
+    struct pool pool;
+};
+
+size_t common_prefix(const char *a, const char *b)
+{
+    size_t i = 0;
+    while (a[i] && a[i] == b[i])
+        ++i;
+    return i;
+}
+
+void getopt_fixture_init(struct getopt_fixture *f, const struct workload *w)
+{
+    char buf[128];
+    int i, j, n = 0;
+
+    memset(f, 0, sizeof(*f));
+    f->longopts = (struct option *)calloc(w->options + 1, sizeof(struct option));
+    f->minlen = (int *)calloc(w->options + 1, sizeof(int));
+
+    // names share first words, as real option sets do
+    for (i = 0; i < w->options; ++i)
+    {
+        if (i < NWORDS)
+            snprintf(buf, sizeof(buf), "%s", words[i]);
+        else if (i < NWORDS * NWORDS)
+            snprintf(buf, sizeof(buf), "%s-%s", words[i / NWORDS], words[i % NWORDS]);
+        else
+            snprintf(buf, sizeof(buf), "%s-%s-%d", words[(i / NWORDS) % NWORDS],
+                     words[i % NWORDS], i);
+        f->longopts[i].name = pool_add(&f->pool, buf);
+        f->longopts[i].has_arg = i % 3;
+    }
+
+    for (i = 0; i < w->options; ++i)
+    {
+        size_t len = strlen(f->longopts[i].name), k = 1;
+        for (j = 0; j < w->options; ++j)
+        {
+            size_t c;
+            if (j == i)
+                continue;
+            c = common_prefix(f->longopts[i].name, f->longopts[j].name);
+            if (c + 1 > k)
+                k = c + 1;
+        }
+        f->minlen[i] = (int)(k < len ? k : len);
+    }
+
+    f->argc = w->args + 1;
+    f->argv = (char **)calloc(f->argc + 1, sizeof(char *));
+    f->scratch = (char **)calloc(f->argc + 1, sizeof(char *));
+    f->argv[n++] = pool_add(&f->pool, "aparsing_bench");
+    while (n < f->argc)
+    {
+        int room = f->argc - n;
+
+        if ((int)(rnd() % 100) < w->operands || w->options == 0)
+        {
+            snprintf(buf, sizeof(buf), "file%d.c", n);
+            f->argv[n++] = pool_add(&f->pool, buf);
+        }
+        else if (rnd() % 5 == 0)
+        {
+            static const char *shorts[] = {"-b", "-bv", "-ax", "-cfoo", "-c", "-v"};
+            if (room >= 2 && rnd() % 3 == 0)
+            {
+                f->argv[n++] = pool_add(&f->pool, rnd() % 2 ? "-a" : "-d");
+                f->argv[n++] = pool_add(&f->pool, "17");
+            }
+            else
+                f->argv[n++] = pool_add(&f->pool, shorts[rnd() % 6]);
+        }
+        else
+        {
+            const struct option *o;
+            int len;
+
+            i = rnd() % w->options;
+            o = &f->longopts[i];
+            len = (int)(rnd() % 100) < w->abbrev ? f->minlen[i] : (int)strlen(o->name);
+            if (o->has_arg == required_argument && room >= 2 && rnd() % 2)
+            {
+                snprintf(buf, sizeof(buf), "--%.*s", len, o->name);
+                f->argv[n++] = pool_add(&f->pool, buf);
+                f->argv[n++] = pool_add(&f->pool, "value");
+            }
+            else
+            {
+                snprintf(buf, sizeof(buf), "--%.*s%s", len, o->name,
+                         o->has_arg == no_argument ? "" : "=value");
+                f->argv[n++] = pool_add(&f->pool, buf);
+            }
+        }
+    }
+
+    f->spec = getopt_compile(short_options, f->longopts);
+}
+
+void getopt_fixture_free(struct getopt_fixture *f)
+{
+    getopt_spec_free(f->spec);
+    pool_free(&f->pool);
+    free(f->longopts);
+    free(f->minlen);
+    free(f->argv);
+    free(f->scratch);
+}
+
+struct param_fixture
+{
+    struct param_info *params;
+    struct param_array *arrays;
+    int *ints;
+    long *elems;
+    unsigned int *nums;
+    int num;
+    int argc;
+    char **argv;
+    FILE *file;         // argv as a parameter file
+    long bytes;
+    struct pool pool;
+};
+
+void param_fixture_init(struct param_fixture *f, const struct workload *w)
+{
+    char buf[64];
+    char *value;
+    int i, k, n = 0;
+    int array = w->array > 0 ? w->array : 1;
+
+    memset(f, 0, sizeof(*f));
+    f->num = w->params;
+    f->params = (struct param_info *)calloc(w->params + 1, sizeof(*f->params));
+    f->arrays = (struct param_array *)calloc(w->params + 1, sizeof(*f->arrays));
+    f->ints = (int *)calloc(w->params + 1, sizeof(int));
+    f->nums = (unsigned int *)calloc(w->params + 1, sizeof(unsigned int));
+    f->elems = (long *)calloc((size_t)(w->params + 1) * array, sizeof(long));
+
+    // a third each of ints, bools and (if any) arrays
+    for (i = 0; i < w->params; ++i)
+    {
+        struct param_info *p = &f->params[i];
+        int kind = i % 3 == 2 && w->array == 0 ? 0 : i % 3;
+
+        snprintf(buf, sizeof(buf), "%s_param_%d", kind == 0 ? "int" : kind == 1 ? "bool" : "array", i);
+        p->name = pool_add(&f->pool, buf);
+        if (kind == 0)
+        {
+            p->set = param_set_int;
+            p->get = param_get_int;
+            p->arg = &f->ints[i];
+        }
+        else if (kind == 1)
+        {
+            p->flags = PARAM_ISBOOL;
+            p->set = param_set_bool;
+            p->get = param_get_bool;
+            p->arg = &f->ints[i];
+        }
+        else
+        {
+            struct param_array *a = &f->arrays[i];
+            a->max = w->array;
+            a->num = &f->nums[i];
+            a->set = param_set_long;
+            a->get = param_get_long;
+            a->elemsize = sizeof(long);
+            a->elem = &f->elems[(size_t)i * array];
+            p->set = param_array_set;
+            p->get = param_array_get;
+            p->arr = a;
+        }
+    }
+
+    value = (char *)malloc(w->array * 12 + 32);
+    f->argc = w->args + 1;
+    f->argv = (char **)calloc(f->argc + 1, sizeof(char *));
+    f->argv[n++] = pool_add(&f->pool, "aparsing_bench");
+    for (; n < f->argc && w->params > 0; ++n)
+    {
+        const struct param_info *p = &f->params[rnd() % w->params];
+
+        if (p->flags & PARAM_ISBOOL)
+            sprintf(value, "%s", p->name);
+        else if (p->set == param_set_int)
+            sprintf(value, "%s=%u", p->name, rnd() % 100000);
+        else
+        {
+            int off = sprintf(value, "%s=", p->name);
+            for (k = 0; k < w->array; ++k)
+                off += sprintf(value + off, k ? ",%u" : "%u", rnd() % 1000);
+        }
+        f->argv[n] = pool_add(&f->pool, value);
+    }
+    f->argc = n;
+    free(value);
+
+    f->file = tmpfile();
+    for (n = 1; f->file && n < f->argc; ++n)
+    {
+        if (n % 16 == 1)
+            f->bytes += fprintf(f->file, "# arguments %d to %d\n", n, n + 15);
+        f->bytes += fprintf(f->file, "%s\n", f->argv[n]);
+    }
+    if (f->file)
+        fflush(f->file);
+}
+
+void param_fixture_free(struct param_fixture *f)
+{
+    pool_free(&f->pool);
+    free(f->params);
+    free(f->arrays);
+    free(f->ints);
+    free(f->nums);
+    free(f->elems);
+    free(f->argv);
+    if (f->file)
+        fclose(f->file);
+}
+
+// ---- parsers: one full parse of the fixture each ----
+
+struct getopt_fixture *gf;
+struct param_fixture *pf;
+static volatile int sink;
+
+void reset_scratch(void)
+{
+    memcpy(gf->scratch, gf->argv, (gf->argc + 1) * sizeof(char *));
+}
+
+void run_getopt_long_r(void)
+{
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    int c, n = 0;
+
+    reset_scratch();
+    state.opterr = 0;
+    while ((c = getopt_long_r(gf->argc, gf->scratch, short_options, gf->longopts,
+                              0, &state)) != -1)
+        n += c;
+    sink = n;
+}
+
+void run_getopt_long_only_r(void)
+{
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    int c, n = 0;
+
+    reset_scratch();
+    state.opterr = 0;
+    while ((c = getopt_long_only_r(gf->argc, gf->scratch, short_options,
+                                   gf->longopts, 0, &state)) != -1)
+        n += c;
+    sink = n;
+}
+
+void run_getopt_long_spec_r(void)
+{
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    int c, n = 0;
+
+    reset_scratch();
+    state.opterr = 0;
+    while ((c = getopt_long_spec_r(gf->argc, gf->scratch, gf->spec, 0, &state)) != -1)
+        n += c;
+    sink = n;
+}
+
+void run_getopt_long(void)
+{
+    int c, n = 0;
+
+    reset_scratch();
+    optind = 0;
+    opterr = 0;
+    while ((c = getopt_long(gf->argc, gf->scratch, short_options, gf->longopts, 0)) != -1)
+        n += c;
+    sink = n;
+}
+
+void run_getopt_long_only(void)
+{
+    int c, n = 0;
+
+    reset_scratch();
+    optind = 0;
+    opterr = 0;
+    while ((c = getopt_long_only(gf->argc, gf->scratch, short_options,
+                                 gf->longopts, 0)) != -1)
+        n += c;
+    sink = n;
+}
+
+void run_parse_args(void)
+{
+    sink = parse_args(pf->params, pf->num, pf->argc, pf->argv, 0);
+}
+
+// mapped, as a regular file is
+void run_parse_args_fd(void)
+{
+    lseek(fileno(pf->file), 0, SEEK_SET);
+    sink = parse_args_fd(pf->params, pf->num, fileno(pf->file), 0);
+}
+
+// read a buffer at a time, as a pipe is
+void run_parse_args_stream(void)
+{
+    lseek(fileno(pf->file), 0, SEEK_SET);
+    sink = parse_args_stream(pf->params, pf->num, fileno(pf->file), 0);
+}
+
+struct parser
+{
+    const char *name;
+    const char *impl;
+    void (*run)(void);
+    int moduleparam;
+    int file;           // reads pf->file
+};
+
+static const struct parser parsers[] =
+{
+#ifdef __GLIBC__
+    {"getopt_long", "host", run_getopt_long, 0, 0},
+    {"getopt_long_only", "host", run_getopt_long_only, 0, 0},
+#else
+    {"getopt_long", "aparsing", run_getopt_long, 0, 0},
+    {"getopt_long_only", "aparsing", run_getopt_long_only, 0, 0},
+#endif
+    {"getopt_long_r", "aparsing", run_getopt_long_r, 0, 0},
+    {"getopt_long_only_r", "aparsing", run_getopt_long_only_r, 0, 0},
+    {"getopt_long_spec_r", "aparsing", run_getopt_long_spec_r, 0, 0},
+    {"parse_args", "aparsing", run_parse_args, 1, 0},
+    {"parse_args_fd", "aparsing", run_parse_args_fd, 1, 1},
+    {"parse_args_stream", "aparsing", run_parse_args_stream, 1, 1},
+};
+
+#define NPARSERS (int)(sizeof(parsers) / sizeof(parsers[0]))
+
+// ---- measurement ----
+
+enum { CYCLES, INSTRUCTIONS, BRANCH_MISSES, NCOUNTERS };
+
+static const char *counter_names[NCOUNTERS] = {"cycles", "instructions", "branch_misses"};
+static int counter_fds[NCOUNTERS] = {-1, -1, -1};
+
+void counters_open(void)
+{
+#ifdef __linux__
+    static const unsigned long long configs[NCOUNTERS] =
+    {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    int i;
+
+    for (i = 0; i < NCOUNTERS; ++i)
+    {
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        counter_fds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+}
+
+void counters_start(void)
+{
+#ifdef __linux__
+    int i;
+    for (i = 0; i < NCOUNTERS; ++i)
+        if (counter_fds[i] >= 0)
+        {
+            ioctl(counter_fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counter_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+}
+
+void counters_stop(long long *values)
+{
+    int i;
+    for (i = 0; i < NCOUNTERS; ++i)
+    {
+        values[i] = -1;
+#ifdef __linux__
+        if (counter_fds[i] >= 0)
+        {
+            long long v;
+            ioctl(counter_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(counter_fds[i], &v, sizeof(v)) == sizeof(v))
+                values[i] = v;
+        }
+#endif
+    }
+}
+
+// a monotonic clock: the wall clock can step, and is coarse on some hosts
+double now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER t, f;
+    QueryPerformanceCounter(&t);
+    QueryPerformanceFrequency(&f);
+    return (double)t.QuadPart / f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+struct result
+{
+    double ns_per_arg;
+    double allocations_per_parse;
+    double counters[NCOUNTERS];     // per argument, or -1
+    double mb_per_s;                // of a parameter file, or -1
+    long long parses;
+};
+
+#define BATCHES 5
+
+// best of BATCHES batches, each at least MINTIME seconds
+void measure(void (*run)(void), int nargs, double mintime, struct result *r)
+{
+    long long iters = 1, total = 0, allocs = 0;
+    long long values[NCOUNTERS], sums[NCOUNTERS] = {0, 0, 0};
+    double best = -1;
+    int b, i;
+
+    // calibrate
+    run();
+    for (;;)
+    {
+        double t = now();
+        long long k;
+        for (k = 0; k < iters; ++k)
+            run();
+        if (now() - t >= mintime / 4 || iters >= (1ll << 40))
+            break;
+        iters *= 2;
+    }
+    iters *= 4;
+
+    for (b = 0; b < BATCHES; ++b)
+    {
+        long long k, a0 = allocations;
+        double t0, t;
+
+        counters_start();
+        t0 = now();
+        for (k = 0; k < iters; ++k)
+            run();
+        t = now() - t0;
+        counters_stop(values);
+        allocs += allocations - a0;
+        total += iters;
+        for (i = 0; i < NCOUNTERS; ++i)
+            sums[i] = values[i] < 0 || sums[i] < 0 ? -1 : sums[i] + values[i];
+        if (best < 0 || t < best)
+            best = t;
+    }
+
+    r->parses = total;
+    r->mb_per_s = -1;
+    r->ns_per_arg = best * 1e9 / iters / (nargs > 0 ? nargs : 1);
+    r->allocations_per_parse = (double)allocs / total;
+    for (i = 0; i < NCOUNTERS; ++i)
+        r->counters[i] = sums[i] < 0 ? -1 : (double)sums[i] / total / (nargs > 0 ? nargs : 1);
+}
+
+// ---- output ----
+
+void print_result(FILE *out, int first, const struct parser *p,
+                  const struct workload *w, const struct result *r)
+{
+    int i;
+
+    fprintf(out, "%s\n    {\"parser\": \"%s\", \"impl\": \"%s\", ", first ? "" : ",", p->name, p->impl);
+    if (p->moduleparam)
+        fprintf(out, "\"workload\": {\"params\": %d, \"array\": %d, \"args\": %d}, ",
+                w->params, w->array, w->args);
+    else
+        fprintf(out, "\"workload\": {\"options\": %d, \"args\": %d, \"abbrev\": %d, \"operands\": %d}, ",
+                w->options, w->args, w->abbrev, w->operands);
+    fprintf(out, "\"parses\": %lld, \"ns_per_arg\": %.3f, ", r->parses, r->ns_per_arg);
+    if (COUNT_ALLOCATIONS)
+        fprintf(out, "\"allocations_per_parse\": %.3f", r->allocations_per_parse);
+    else
+        fprintf(out, "\"allocations_per_parse\": null");
+    for (i = 0; i < NCOUNTERS; ++i)
+    {
+        if (r->counters[i] < 0)
+            fprintf(out, ", \"%s_per_arg\": null", counter_names[i]);
+        else
+            fprintf(out, ", \"%s_per_arg\": %.3f", counter_names[i], r->counters[i]);
+    }
+    if (r->mb_per_s >= 0)
+        fprintf(out, ", \"mb_per_s\": %.1f", r->mb_per_s);
+    fprintf(out, "}");
+}
+
+// ---- main ----
+
+void usage(void)
+{
+    printf("usage: aparsing_bench [options]\n"
+           "  --options LIST    long options defined (8,64,512)\n"
+           "  --args LIST       argv elements after the program name (16,256,4096)\n"
+           "  --abbrev LIST     percent of long options abbreviated (0,50)\n"
+           "  --operands LIST   percent of elements that are operands (0,50)\n"
+           "  --params LIST     moduleparam parameters defined (8,64,512)\n"
+           "  --array LIST      elements of each array parameter (0,16)\n"
+           "  --parser NAME     only run this parser (all)\n"
+           "  --time MS         least time of each of the %d batches (10)\n"
+           "  --seed N          workload generator seed\n"
+           "  --output FILE     write the JSON here (stdout)\n"
+           "LIST is comma-separated; every combination is measured.\n",
+           BATCHES);
+}
+
+int parse_list(const char *s, struct list *l)
+{
+    char *end;
+
+    l->n = 0;
+    do
+    {
+        long v = strtol(s, &end, 10);
+        if (end == s || v < 0 || l->n == MAXLIST)
+            return -1;
+        l->v[l->n++] = (int)v;
+        s = end + 1;
+    } while (*end == ',');
+    return *end ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    static struct option long_options[] =
+    {
+        {"options", required_argument, 0, 'o'},
+        {"args", required_argument, 0, 'n'},
+        {"abbrev", required_argument, 0, 'b'},
+        {"operands", required_argument, 0, 'p'},
+        {"params", required_argument, 0, 'm'},
+        {"array", required_argument, 0, 'y'},
+        {"parser", required_argument, 0, 'P'},
+        {"time", required_argument, 0, 't'},
+        {"seed", required_argument, 0, 's'},
+        {"output", required_argument, 0, 'O'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    struct list options = {3, {8, 64, 512}}, args = {3, {16, 256, 4096}};
+    struct list abbrev = {2, {0, 50}}, operands = {2, {0, 50}};
+    struct list params = {3, {8, 64, 512}}, array = {2, {0, 16}};
+    const char *only = 0;
+    double mintime = 0.010;
+    unsigned long long seed = rng_state;
+    FILE *out = stdout;
+    int first = 1;
+    int c, i, a, b, o, p;
+
+    while ((c = getopt_long_r(argc, argv, "h", long_options, 0, &state)) != -1)
+    {
+        struct list *l = 0;
+
+        switch (c)
+        {
+            case 'o': l = &options; break;
+            case 'n': l = &args; break;
+            case 'b': l = &abbrev; break;
+            case 'p': l = &operands; break;
+            case 'm': l = &params; break;
+            case 'y': l = &array; break;
+            case 'P': only = state.optarg; break;
+            case 't': mintime = atof(state.optarg) / 1000; break;
+            case 's': seed = strtoull(state.optarg, 0, 10) | 1; break;
+            case 'O':
+                out = fopen(state.optarg, "w");
+                if (!out)
+                {
+                    fprintf(stderr, "cannot write %s\n", state.optarg);
+                    return 1;
+                }
+                break;
+            case 'h':
+                usage();
+                return 0;
+            default:
+                usage();
+                return 1;
+        }
+        if (l && parse_list(state.optarg, l) < 0)
+        {
+            fprintf(stderr, "bad list '%s'\n", state.optarg);
+            return 1;
+        }
+    }
+
+    counters_open();
+    fprintf(out, "{\n  \"benchmark\": \"aparsing_bench\",\n");
+#ifdef __GLIBC__
+    fprintf(out, "  \"host_libc\": \"glibc %s\",\n", gnu_get_libc_version());
+#else
+    fprintf(out, "  \"host_libc\": null,\n");
+#endif
+    fprintf(out, "  \"perf_events\": %s,\n", counter_fds[CYCLES] >= 0 ? "true" : "false");
+    fprintf(out, "  \"batches\": %d,\n  \"min_batch_ms\": %.3f,\n", BATCHES, mintime * 1000);
+    fprintf(out, "  \"results\": [");
+
+    // getopt: options x args x abbrev x operands
+    for (o = 0; o < options.n; ++o)
+    for (a = 0; a < args.n; ++a)
+    for (b = 0; b < abbrev.n; ++b)
+    for (p = 0; p < operands.n; ++p)
+    {
+        struct workload w = {options.v[o], args.v[a], abbrev.v[b], operands.v[p], 0, 0};
+        struct getopt_fixture fixture;
+
+        rng_state = seed;
+        getopt_fixture_init(&fixture, &w);
+        gf = &fixture;
+        for (i = 0; i < NPARSERS; ++i)
+        {
+            struct result r;
+            if (parsers[i].moduleparam || (only && strcmp(only, parsers[i].name)))
+                continue;
+            fprintf(stderr, "%s options=%d args=%d abbrev=%d operands=%d\n", parsers[i].name,
+                    w.options, w.args, w.abbrev, w.operands);
+            measure(parsers[i].run, w.args, mintime, &r);
+            print_result(out, first, &parsers[i], &w, &r);
+            first = 0;
+        }
+        getopt_fixture_free(&fixture);
+    }
+
+    // moduleparam: params x array x args
+    for (p = 0; p < params.n; ++p)
+    for (b = 0; b < array.n; ++b)
+    for (a = 0; a < args.n; ++a)
+    {
+        struct workload w = {0, args.v[a], 0, 0, params.v[p], array.v[b]};
+        struct param_fixture fixture;
+
+        rng_state = seed;
+        param_fixture_init(&fixture, &w);
+        pf = &fixture;
+        for (i = 0; i < NPARSERS; ++i)
+        {
+            struct result r;
+            if (!parsers[i].moduleparam || (only && strcmp(only, parsers[i].name))
+                || (parsers[i].file && !fixture.file))
+                continue;
+            fprintf(stderr, "%s params=%d array=%d args=%d\n", parsers[i].name,
+                    w.params, w.array, w.args);
+            measure(parsers[i].run, fixture.argc - 1, mintime, &r);
+            if (parsers[i].file)
+                r.mb_per_s = fixture.bytes / (r.ns_per_arg * (fixture.argc > 1 ? fixture.argc - 1 : 1)) * 1e3;
+            print_result(out, first, &parsers[i], &w, &r);
+            first = 0;
+        }
+        param_fixture_free(&fixture);
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
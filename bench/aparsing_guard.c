@@ -0,0 +1,645 @@
+// aparsing_guard: make sure no parser is super-linear on hostile input
+//
+// Each case builds a pathological input of growing size n, times a parse
+// of it, and fits the exponent k of time ~ n^k by least squares over the
+// logarithms.  The exit status is 1 if any exponent is above the limit,
+// so that services parsing untrusted argument strings can run this after
+// every change.  A size whose parse takes longer than the time budget
+// ends its case early; the sizes measured until then are fitted, and a
+// case that cannot measure two sizes within the budget fails.  So does a
+// case whose parse returns an error, as it would time nothing.
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+# include <windows.h>
+#endif
+
+#include "moduleparam.h"
+
+static char short_options[] = "a:bc::d:v";
+
+// the program's option table is fixed; only argv is hostile.  The long
+// names share long prefixes, so abbreviations are compared at length.
+#define NLONG 256
+static struct option long_options[NLONG + 1];
+static char long_names[NLONG][48];
+
+void init_long_options(void)
+{
+    int i;
+
+    for (i = 0; i < NLONG; ++i)
+    {
+        snprintf(long_names[i], sizeof(long_names[i]),
+                 "common-prefix-shared-by-all-%03d", i);
+        long_options[i].name = long_names[i];
+        long_options[i].has_arg = i % 3;
+        long_options[i].val = i + 256;
+    }
+}
+
+// a monotonic clock: the wall clock can step, and is coarse on some hosts
+double now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER t, f;
+    QueryPerformanceCounter(&t);
+    QueryPerformanceFrequency(&f);
+    return (double)t.QuadPart / f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+// ---- inputs ----
+
+// argv of N elements, each a copy of PATTERN[i % NPATTERN]
+char **make_argv(int n, const char *const *pattern, int npattern)
+{
+    char **argv = (char **)malloc((n + 2) * sizeof(char *));
+    int i;
+
+    argv[0] = (char *)"guard";
+    for (i = 1; i <= n; ++i)
+        argv[i] = (char *)pattern[(i - 1) % npattern];
+    argv[n + 1] = 0;
+    return argv;
+}
+
+// a string of about N characters: PATTERN repeated, whole, so that no
+// quote is left open at the end
+char *make_string(int n, const char *prefix, const char *pattern, const char *suffix)
+{
+    size_t plen = strlen(prefix), len = strlen(pattern), slen = strlen(suffix);
+    char *s = (char *)malloc(plen + n + slen + 1);
+    int i;
+
+    if ((size_t)n > len)
+        n -= n % len;
+    memcpy(s, prefix, plen);
+    for (i = 0; i < n; ++i)
+        s[plen + i] = pattern[i % len];
+    memcpy(s + plen + n, suffix, slen + 1);
+    return s;
+}
+
+// ---- cases: each builds an input of size N, outside the clock, then
+// parses it once per run and returns nonzero if the parse stopped on an
+// error instead of reading it all.  A scan that permutes its argv or a
+// parse that cuts its string up in place runs on a fresh copy, which is
+// a plain linear copy next to the parse being timed ----
+
+struct input
+{
+    int argc;
+    char **argv;
+    char **work;                // the copy a run scans
+    char *text;
+    size_t len;
+    char *scratch;              // the copy a run cuts up
+    struct getopt_view *views;
+    int *operands;
+    struct getopt_arena arena;
+    struct param_info *params;
+    int nparams;
+    char *names;
+    char *args;
+    FILE *file;
+};
+
+void free_input(struct input *in)
+{
+    free(in->argv);
+    free(in->work);
+    free(in->text);
+    free(in->scratch);
+    free(in->views);
+    free(in->operands);
+    free(in->arena.base);
+    free(in->params);
+    free(in->names);
+    free(in->args);
+    if (in->file)
+        fclose(in->file);
+    memset(in, 0, sizeof(*in));
+}
+
+void input_argv(struct input *in, int n, const char *const *pattern, int npattern)
+{
+    in->argc = n + 1;
+    in->argv = make_argv(n, pattern, npattern);
+    in->work = (char **)malloc((n + 2) * sizeof(char *));
+}
+
+// COPIES of one argument of about N characters
+void input_arg(struct input *in, int n, const char *prefix, const char *pattern, int copies)
+{
+    int i;
+
+    in->text = make_string(n, prefix, pattern, "");
+    in->argc = copies + 1;
+    in->argv = (char **)malloc((copies + 2) * sizeof(char *));
+    in->work = (char **)malloc((copies + 2) * sizeof(char *));
+    in->argv[0] = (char *)"guard";
+    for (i = 1; i <= copies; ++i)
+        in->argv[i] = in->text;
+    in->argv[copies + 1] = 0;
+}
+
+void input_text(struct input *in, int n, const char *pattern)
+{
+    in->text = make_string(n, "", pattern, "");
+    in->len = strlen(in->text);
+    in->scratch = (char *)malloc(in->len + 1);
+}
+
+char **fresh_argv(struct input *in)
+{
+    memcpy(in->work, in->argv, (in->argc + 1) * sizeof(char *));
+    return in->work;
+}
+
+char *fresh_text(struct input *in)
+{
+    memcpy(in->scratch, in->text, in->len + 1);
+    return in->scratch;
+}
+
+struct getopt_spec *spec;
+struct getopt_nameindex *names;
+
+void scan_r(int argc, char **argv, int long_only, const struct getopt_nameindex *index)
+{
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+
+    state.opterr = 0;
+    state.nameindex = index;
+    if (long_only)
+        while (getopt_long_only_r(argc, argv, short_options, long_options, 0, &state) != -1)
+            ;
+    else
+        while (getopt_long_r(argc, argv, short_options, long_options, 0, &state) != -1)
+            ;
+}
+
+int run_scan(struct input *in)
+{
+    scan_r(in->argc, fresh_argv(in), 0, 0);
+    return 0;
+}
+
+// options and operands alternating: the classic exchange() worst case
+void build_permute(struct input *in, int n)
+{
+    static const char *const p[] = {"-b", "operand"};
+    input_argv(in, n, p, 2);
+}
+
+// every element an ambiguous abbreviation of all the long options
+void build_ambiguous(struct input *in, int n)
+{
+    static const char *const p[] = {"--common-prefix-shared-by-all-0"};
+    input_argv(in, n, p, 1);
+}
+
+// the same through getopt_long_only, which tries every -x as long first
+void build_long_only(struct input *in, int n)
+{
+    static const char *const p[] = {"-common-prefix-shared-by-all-0", "-bvbvbv"};
+    input_argv(in, n, p, 2);
+}
+
+int run_long_only(struct input *in)
+{
+    scan_r(in->argc, fresh_argv(in), 1, 0);
+    return 0;
+}
+
+// one long option of N characters, almost matching all of them
+void build_long_name(struct input *in, int n)
+{
+    input_arg(in, n, "--common-prefix-shared-by-all-", "0", 1);
+}
+
+// one cluster of N short options
+void build_short_cluster(struct input *in, int n)
+{
+    input_arg(in, n, "-", "bv", 1);
+}
+
+// unknown long options of N characters, with suggestions looked up
+void build_suggest(struct input *in, int n)
+{
+    input_arg(in, n, "--", "common-prefix-", 3);
+}
+
+int run_suggest(struct input *in)
+{
+    scan_r(in->argc, fresh_argv(in), 0, names);
+    return 0;
+}
+
+// the compiled-spec scans, non-permuting
+static const char *const mixed[] = {"-b", "operand", "--common-prefix-shared-by-all-0", "-a", "x"};
+
+void build_parse_all(struct input *in, int n)
+{
+    input_argv(in, n, mixed, 5);
+    in->operands = (int *)malloc((n + 1) * sizeof(int));
+}
+
+int run_parse_all(struct input *in)
+{
+    struct getopt_event events[16];
+    int noperands;
+
+    return getopt_parse_all_operands(in->argc, in->argv, spec, GETOPT_PARSE_QUIET, events, 16,
+                                     in->operands, &noperands) < 0;
+}
+
+void build_view(struct input *in, int n)
+{
+    int i;
+
+    in->argc = n + 1;
+    in->views = (struct getopt_view *)malloc((n + 1) * sizeof(*in->views));
+    in->operands = (int *)malloc((n + 1) * sizeof(int));
+    in->views[0].ptr = "guard";
+    in->views[0].len = 5;
+    for (i = 1; i <= n; ++i)
+    {
+        in->views[i].ptr = mixed[(i - 1) % 5];
+        in->views[i].len = strlen(in->views[i].ptr);
+    }
+}
+
+int run_view(struct input *in)
+{
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+
+    state.opterr = 0;
+    state.operands = in->operands;
+    while (getopt_long_view_r(in->argc, in->views, spec, 0, &state) != -1)
+        ;
+    return 0;
+}
+
+// elements handed out one at a time from the views
+struct elements
+{
+    const struct getopt_view *views;
+    int i, n;
+};
+
+int next_element(void *cookie, struct getopt_view *elt)
+{
+    struct elements *e = (struct elements *)cookie;
+
+    if (e->i >= e->n)
+        return 0;
+    *elt = e->views[e->i++];
+    return 1;
+}
+
+int run_stream(struct input *in)
+{
+    struct elements e = {in->views, 0, in->argc};
+    struct getopt_stream stream;
+
+    getopt_stream_init(&stream, next_element, &e);
+    stream.state.opterr = 0;
+    while (getopt_long_stream_r(&stream, spec, 0) != -1)
+        ;
+    return 0;
+}
+
+// a line of N characters: quoted runs, escapes, empty words
+void build_split(struct input *in, int n)
+{
+    input_text(in, n, "'a b' \"c\\\"d\" e\\ f '' ");
+    in->arena.size = GETOPT_SPLIT_ARENA_SIZE(in->len);
+    in->arena.base = (char *)malloc(in->arena.size);
+}
+
+int run_split(struct input *in)
+{
+    char **argv;
+
+    in->arena.used = 0;
+    return getopt_split(fresh_text(in), 0, &in->arena, &argv) < 0;
+}
+
+// moduleparam: N short params, and one quoted value of N characters
+static int guard_int;
+static struct param_info guard_params[2];
+
+int ignore_unknown(char *param, char *val)
+{
+    return 0;
+}
+
+int ignore_unknown_view(const char *param, size_t len, const char *val, size_t vallen)
+{
+    return 0;
+}
+
+// parse_args leaves its argv as it is
+int run_parse_args(struct input *in)
+{
+    return parse_args(guard_params, 1, in->argc, in->argv, ignore_unknown);
+}
+
+void build_parse_args_many(struct input *in, int n)
+{
+    static const char *const p[] = {"x=1", "guard_int=2"};
+    input_argv(in, n, p, 2);
+}
+
+void build_parse_args_unknown(struct input *in, int n)
+{
+    static const char *const p[] = {"x=1", "y", "guard-int=3"};
+    input_argv(in, n, p, 3);
+}
+
+// one string of N characters in quoted words, cut up in place
+void build_parse_args_text(struct input *in, int n)
+{
+    input_text(in, n, "x=\"a b\" \"y=c d\" z ");
+}
+
+int run_parse_args_string(struct input *in)
+{
+    return parse_args_string(guard_params, 1, fresh_text(in), ignore_unknown);
+}
+
+// one quoted value of N characters: argv values are taken as they are,
+// so the quotes are read in a string
+void build_parse_args_quoted(struct input *in, int n)
+{
+    in->text = make_string(n, "x=\"", "a b=", "\"");
+    in->len = strlen(in->text);
+    in->scratch = (char *)malloc(in->len + 1);
+}
+
+// the same, read-only
+int run_parse_args_buf(struct input *in)
+{
+    return parse_args_buf(guard_params, 1, in->text, in->len, ignore_unknown_view);
+}
+
+// a parameter file of N characters with comments and continued lines,
+// read a buffer at a time
+void build_parse_args_stream(struct input *in, int n)
+{
+    char *text = make_string(n, "", "x=\"a b\" # c \"d\n y=e\\\nf z ", "");
+
+    in->file = tmpfile();
+    if (in->file)
+    {
+        fwrite(text, 1, strlen(text), in->file);
+        fflush(in->file);
+    }
+    free(text);
+}
+
+int run_parse_args_stream(struct input *in)
+{
+    if (!in->file)
+        return -1;
+    rewind(in->file);
+    return parse_args_stream(guard_params, 1, fileno(in->file), ignore_unknown_view);
+}
+
+// N arguments setting N / 16 registered params by name: the table grows
+// with the input but stays small enough not to time the cache instead
+void build_parse_args_registry(struct input *in, int n)
+{
+    static const char *const p[] = {""};
+    int i;
+
+    in->nparams = n / 16 + 1;
+    in->params = (struct param_info *)calloc(in->nparams, sizeof(*in->params));
+    in->names = (char *)malloc((size_t)in->nparams * 16);
+    in->args = (char *)malloc((size_t)n * 24);
+    input_argv(in, n, p, 1);
+    for (i = 0; i < in->nparams; i++)
+    {
+        sprintf(in->names + i * 16, "p_%d", i);
+        in->params[i].name = in->names + i * 16;
+        in->params[i].set = param_set_int;
+        in->params[i].arg = &guard_int;
+    }
+    // spelled with a dash, in no particular order
+    for (i = 0; i < n; i++)
+    {
+        sprintf(in->args + i * 24, "p-%d=%d", (int)((i * 7919LL) % in->nparams), i);
+        in->argv[i + 1] = in->args + i * 24;
+    }
+}
+
+int run_parse_args_registry(struct input *in)
+{
+    return parse_args(in->params, in->nparams, in->argc, in->argv, ignore_unknown);
+}
+
+struct guard_case
+{
+    const char *name;
+    void (*build)(struct input *in, int n);
+    int (*run)(struct input *in);
+};
+
+static const struct guard_case cases[] =
+{
+    {"getopt_long_r permute", build_permute, run_scan},
+    {"getopt_long_r ambiguous", build_ambiguous, run_scan},
+    {"getopt_long_only_r", build_long_only, run_long_only},
+    {"getopt_long_r long name", build_long_name, run_scan},
+    {"getopt_long_r short cluster", build_short_cluster, run_scan},
+    {"getopt_long_r suggestions", build_suggest, run_suggest},
+    {"getopt_parse_all_operands", build_parse_all, run_parse_all},
+    {"getopt_long_view_r", build_view, run_view},
+    {"getopt_long_stream_r", build_view, run_stream},
+    {"getopt_split", build_split, run_split},
+    {"parse_args many", build_parse_args_many, run_parse_args},
+    {"parse_args quoted", build_parse_args_quoted, run_parse_args_string},
+    {"parse_args unknown", build_parse_args_unknown, run_parse_args},
+    {"parse_args_string", build_parse_args_text, run_parse_args_string},
+    {"parse_args_buf", build_parse_args_text, run_parse_args_buf},
+    {"parse_args_stream", build_parse_args_stream, run_parse_args_stream},
+    {"parse_args registry", build_parse_args_registry, run_parse_args_registry},
+};
+
+#define NCASES (int)(sizeof(cases) / sizeof(cases[0]))
+
+// ---- fitting ----
+
+#define MAXSIZES 32
+
+// best of three, repeated REPS times over an input built beforehand; -1
+// if a parse failed, since the time of a parse that gave up early says
+// nothing about the input
+double time_case(const struct guard_case *c, int n, int reps)
+{
+    struct input in;
+    double best = -1;
+    int k, r, failed = 0;
+
+    memset(&in, 0, sizeof(in));
+    c->build(&in, n);
+    for (k = 0; k < 3 && !failed; ++k)
+    {
+        double t0 = now(), t;
+        for (r = 0; r < reps; ++r)
+            failed |= c->run(&in) != 0;
+        t = now() - t0;
+        if (best < 0 || t < best)
+            best = t;
+    }
+    free_input(&in);
+    return failed ? -1 : best / reps;
+}
+
+// least-squares slope of log t over log n
+double fit_exponent(const int *sizes, const double *times, int count)
+{
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        double x = log((double)sizes[i]), y = log(times[i]);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    return (count * sxy - sx * sy) / (count * sxx - sx * sx);
+}
+
+void usage(void)
+{
+    printf("usage: aparsing_guard [options]\n"
+           "  --min N           smallest input size (1024)\n"
+           "  --max N           largest input size (262144)\n"
+           "  --max-exponent K  fail above this exponent (1.3)\n"
+           "  --budget MS       stop growing a case past this time (2000)\n"
+           "  --case NAME       only run the cases starting with NAME\n");
+}
+
+int main(int argc, char **argv)
+{
+    static struct option options[] =
+    {
+        {"min", required_argument, 0, 'm'},
+        {"max", required_argument, 0, 'M'},
+        {"max-exponent", required_argument, 0, 'k'},
+        {"budget", required_argument, 0, 'b'},
+        {"case", required_argument, 0, 'c'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    int minsize = 1024, maxsize = 262144;
+    double maxexp = 1.3, budget = 2.0;
+    const char *only = 0;
+    int failed = 0, first = 1;
+    int c, i;
+
+    while ((c = getopt_long_r(argc, argv, "h", options, 0, &state)) != -1)
+    {
+        switch (c)
+        {
+            case 'm': minsize = atoi(state.optarg); break;
+            case 'M': maxsize = atoi(state.optarg); break;
+            case 'k': maxexp = atof(state.optarg); break;
+            case 'b': budget = atof(state.optarg) / 1000; break;
+            case 'c': only = state.optarg; break;
+            case 'h': usage(); return 0;
+            default: usage(); return 2;
+        }
+    }
+    if (minsize < 16 || maxsize < minsize * 4)
+    {
+        usage();
+        return 2;
+    }
+
+    init_long_options();
+    spec = getopt_compile(short_options, long_options);
+    names = getopt_nameindex_new(&long_options[0].name, NLONG, sizeof(struct option));
+    guard_params[0].name = "guard_int";
+    guard_params[0].set = param_set_int;
+    guard_params[0].get = param_get_int;
+    guard_params[0].arg = &guard_int;
+
+    printf("{\n  \"max_exponent\": %.2f,\n  \"cases\": [", maxexp);
+    for (i = 0; i < NCASES; ++i)
+    {
+        const struct guard_case *gc = &cases[i];
+        int sizes[MAXSIZES];
+        double times[MAXSIZES];
+        int count = 0, reps = 1, n;
+        int parsed = 1;
+        double k, t;
+        int ok;
+
+        if (only && strncmp(gc->name, only, strlen(only)))
+            continue;
+
+        // enough repetitions for the smallest size to take a millisecond
+        while ((t = time_case(gc, minsize, reps)) >= 0 && t * reps < 1e-3 && reps < (1 << 20))
+            reps *= 2;
+
+        for (n = minsize; n <= maxsize && count < MAXSIZES; n *= 2)
+        {
+            t = time_case(gc, n, reps);
+            if (t < 0)
+            {
+                parsed = 0;
+                break;
+            }
+            sizes[count] = n;
+            times[count++] = t > 0 ? t : 1e-9;
+            if (t * reps * 3 > budget)
+                break;
+        }
+
+        // a single size is too slow to grow, which is the worst outcome
+        k = count >= 2 ? fit_exponent(sizes, times, count) : -1;
+        ok = parsed && count >= 2 && k <= maxexp;
+        if (!parsed)
+            fprintf(stderr, "%-32s parse failed at size %d  FAIL\n", gc->name, n);
+        else if (count >= 2)
+            fprintf(stderr, "%-32s exponent %.2f over %d sizes up to %d%s\n", gc->name, k,
+                    count, sizes[count - 1], ok ? "" : "  FAIL");
+        else
+            fprintf(stderr, "%-32s over budget at size %d  FAIL\n", gc->name, sizes[0]);
+        printf("%s\n    {\"case\": \"%s\", ", first ? "" : ",", gc->name);
+        if (parsed && count >= 2)
+            printf("\"exponent\": %.3f, ", k);
+        else
+            printf("\"exponent\": null, ");
+        if (count > 0)
+            printf("\"sizes\": %d, \"largest\": %d, \"seconds_at_largest\": %.6f, ",
+                   count, sizes[count - 1], times[count - 1]);
+        else
+            printf("\"sizes\": 0, ");
+        printf("\"parsed\": %s, \"ok\": %s}", parsed ? "true" : "false", ok ? "true" : "false");
+        first = 0;
+        failed |= !ok;
+    }
+    printf("\n  ],\n  \"ok\": %s\n}\n", failed ? "false" : "true");
+
+    getopt_nameindex_free(names);
+    getopt_spec_free(spec);
+    return failed;
+}
@@ -57,7 +57,9 @@
 # endif
 #endif
 
-#ifndef ELIDE_CODE
+/* The reentrant interface (`getopt_r' and friends) is not part of the
+   GNU C Library, so it is compiled regardless; ELIDE_CODE only drops the
+   entry points that work on the global `optind', `optarg' etc.  */
 
 /* This needs to come after some library #include
    to get __GNU_LIBRARY__ defined.  */
@@ -66,6 +68,11 @@
    contain conflicting prototypes for getopt.  */
 # include <stdlib.h>
 # include <unistd.h>
+#else
+/* The permutation bookkeeping needs malloc and free; `getopt' itself is
+   declared with a full prototype in getopt.h, which wins over any older
+   declaration in stdlib.h.  */
+# include <stdlib.h>
 #endif	/* GNU C library.  */
 
 #ifdef VMS
@@ -102,6 +109,10 @@
    they can distinguish the relative order of options and other arguments.  */
 
 #include "getopt.h"
+#include "getopt_int.h"
+#include "getopt_probe.h"
+
+#ifndef ELIDE_CODE
 
 /* For communication from `getopt' to the caller.
    When `getopt' finds an option that takes an argument,
@@ -126,21 +137,6 @@ char *optarg;
 /* 1003.2 says this must be 1 before any call.  */
 int optind = 1;
 
-/* Formerly, initialization of getopt depended on optind==0, which
-   causes problems with re-calling getopt as programs generally don't
-   know that. */
-
-int __getopt_initialized;
-
-/* The next char to be scanned in the option-element
-   in which the last option character we returned was found.
-   This allows us to pick up the scan where we left off.
-
-   If this is zero, or a null string, it means resume the scan
-   by advancing to the next ARGV-element.  */
-
-static char *nextchar;
-
 /* Callers store zero here to inhibit the error message
    for unrecognized options.  */
 
@@ -152,7 +148,27 @@ int opterr = 1;
 
 int optopt = '?';
 
-/* Describe how to deal with options that follow non-option ARGV-elements.
+/* Keep a global copy of all internal members of getopt_data.  */
+
+static struct getopt_state getopt_data;
+
+#endif	/* Not ELIDE_CODE.  */
+
+/* The rest of the scan state lives in `struct getopt_state' (see
+   getopt.h), one per scan:
+
+   `__nextchar' is the next char to be scanned in the option-element
+   in which the last option character we returned was found.
+   This allows us to pick up the scan where we left off.
+   If this is zero, or a null string, it means resume the scan
+   by advancing to the next ARGV-element.
+
+   `__initialized' replaces the old rule that initialization of getopt
+   depended on optind==0, which causes problems with re-calling getopt
+   as programs generally don't know that.
+
+   `__ordering' describes how to deal with options that follow
+   non-option ARGV-elements.
 
    If the caller did not specify anything,
    the default is REQUIRE_ORDER if the environment variable
@@ -179,15 +195,10 @@ int optopt = '?';
 
    The special argument `--' forces an end of option-scanning regardless
    of the value of `ordering'.  In the case of RETURN_IN_ORDER, only
-   `--' can cause `getopt' to return -1 with `optind' != ARGC.  */
+   `--' can cause `getopt' to return -1 with `optind' != ARGC.
 
-static enum
-{
-  REQUIRE_ORDER, PERMUTE, RETURN_IN_ORDER
-} ordering;
-
-/* Value of POSIXLY_CORRECT environment variable.  */
-static char *posixly_correct;
+   `__posixly_correct' records whether the POSIXLY_CORRECT environment
+   variable was set when the scan started.  */
 
 #ifdef	__GNU_LIBRARY__
 /* We want to avoid inclusion of string.h with non-GNU libraries
@@ -246,11 +257,8 @@ extern int strlen (const char *);
 /* Handle permutation of arguments.  */
 
 /* Describe the part of ARGV that contains non-options that have
-   been skipped.  `first_nonopt' is the index in ARGV of the first of them;
-   `last_nonopt' is the index after the last of them.  */
-
-static int first_nonopt;
-static int last_nonopt;
+   been skipped.  `d->__first_nonopt' is the index in ARGV of the first
+   of them; `d->__last_nonopt' is the index after the last of them.  */
 
 #ifdef _LIBC
 /* Stored original parameters.
@@ -288,25 +296,29 @@ static int nonoption_flags_len;
 /* Exchange two adjacent subsequences of ARGV.
    One subsequence is elements [first_nonopt,last_nonopt)
    which contains all the non-options that have been skipped so far.
-   The other is elements [last_nonopt,optind), which contains all
+   The other is elements [last_nonopt,top), which contains all
    the options processed since those non-options were skipped.
 
    `first_nonopt' and `last_nonopt' are relocated so that they describe
    the new indices of the non-options in ARGV after they are moved.  */
 
 #if defined __STDC__ && __STDC__
-static void exchange (char **);
+static void exchange (char **, int, struct getopt_state *);
 #endif
 
 static void
-exchange (argv)
+exchange (argv, top, d)
      char **argv;
+     int top;
+     struct getopt_state *d;
 {
-  int bottom = first_nonopt;
-  int middle = last_nonopt;
-  int top = optind;
+  int bottom = d->__first_nonopt;
+  int middle = d->__last_nonopt;
+  int end = top;
   char *tem;
 
+  GETOPT_PROBE3 (getopt, exchange, bottom, middle - bottom, top - middle);
+
   /* Exchange the shorter segment with the far end of the longer segment.
      That puts the shorter segment into the right place.
      It leaves the longer segment in the right place overall,
@@ -374,50 +386,238 @@ exchange (argv)
 
   /* Update records for the slots the non-options now occupy.  */
 
-  first_nonopt += (optind - last_nonopt);
-  last_nonopt = optind;
+  d->__first_nonopt += (end - d->__last_nonopt);
+  d->__last_nonopt = end;
+}
+
+/* Exchanging the non-options with the options that follow them every time
+   there are some costs time proportional to all the non-options skipped so
+   far, which adds up to quadratic time when options and non-options
+   alternate.  Instead, once options have followed non-options, the runs of
+   non-options are only recorded in `__runs' (pairs of start and end
+   indices, `__nruns' of them, `__npending' elements in all) and left in
+   place, and `permute_pending' moves everything into order when the scan
+   reaches its end.  While `__nruns' is zero the skipped non-options are
+   just [first_nonopt,last_nonopt), as in the classic scheme.
+
+   The first _GETOPT_INLINE_RUNS runs are kept in `__inlineruns', with
+   `__runs' null, and are merged in place by exchanging each run with the
+   options before the next: a few passes over ARGV, and no memory to
+   allocate.  Only more runs are moved to the heap, and then put in order
+   in one pass with the non-options saved on the side.  */
+
+#define RUNS(d) ((d)->__runs != NULL ? (d)->__runs : (d)->__inlineruns)
+
+#define PENDING_NONOPTS(d) \
+  ((d)->__nruns ? (d)->__npending : (d)->__last_nonopt - (d)->__first_nonopt)
+
+#if defined __STDC__ && __STDC__
+static void free_runs (struct getopt_state *);
+static void merge_runs (char **, struct getopt_state *);
+static void record_run (char **, int, int, struct getopt_state *);
+static void permute_pending (char **, struct getopt_state *);
+#endif
+
+static void
+free_runs (d)
+     struct getopt_state *d;
+{
+  free (d->__runs);
+  d->__runs = NULL;
+  d->__nruns = d->__maxruns = 0;
+  d->__npending = 0;
+}
+
+/* Bring the recorded runs of non-options together in front of `optind'
+   the classic way, by exchanging them with the options in between one
+   run at a time.  Needs no memory: used for the runs kept inline, and
+   when there is no memory to be had.  */
+
+static void
+merge_runs (argv, d)
+     char **argv;
+     struct getopt_state *d;
+{
+  int *runs = RUNS (d);
+  int i;
+
+  d->__first_nonopt = runs[0];
+  d->__last_nonopt = runs[1];
+  for (i = 1; i < d->__nruns; i++)
+    {
+      exchange (argv, runs[2 * i], d);
+      d->__last_nonopt = runs[2 * i + 1];
+    }
+  free_runs (d);
+}
+
+/* Note that the non-options [START,END) were skipped after some options
+   which themselves follow earlier non-options.  */
+
+static void
+record_run (argv, start, end, d)
+     char **argv;
+     int start;
+     int end;
+     struct getopt_state *d;
+{
+  int *runs;
+
+  if (d->__nruns == 0)
+    {
+      /* Options have come between non-options for the first time; from
+	 now on keep a list, inline to begin with.  */
+      d->__npending = d->__last_nonopt - d->__first_nonopt;
+      d->__maxruns = _GETOPT_INLINE_RUNS;
+      d->__inlineruns[0] = d->__first_nonopt;
+      d->__inlineruns[1] = d->__last_nonopt;
+      d->__nruns = 1;
+    }
+  else if (d->__nruns == d->__maxruns)
+    {
+      if (d->__runs == NULL)
+	{
+	  runs = (int *) malloc (4 * d->__maxruns * sizeof (int));
+	  if (runs != NULL)
+	    memcpy (runs, d->__inlineruns, sizeof d->__inlineruns);
+	}
+      else
+	runs = (int *) realloc (d->__runs, 4 * d->__maxruns * sizeof (int));
+      if (runs == NULL)
+	{
+	  merge_runs (argv, d);
+	  exchange (argv, start, d);
+	  return;
+	}
+      d->__runs = runs;
+      d->__maxruns *= 2;
+    }
+  runs = RUNS (d);
+  runs[2 * d->__nruns] = start;
+  runs[2 * d->__nruns + 1] = end;
+  d->__nruns++;
+  d->__npending += end - start;
+}
+
+/* Move all options processed so far, up to `optind', in front of all
+   non-options skipped so far, keeping the order within both groups.  */
+
+static void
+permute_pending (argv, d)
+     char **argv;
+     struct getopt_state *d;
+{
+  char **nonopts = NULL;
+  int *runs = d->__runs;
+  int from, to, n, i;
+
+  if (d->__nruns == 0)
+    {
+      if (d->__first_nonopt != d->__last_nonopt
+	  && d->__last_nonopt != d->optind)
+	exchange (argv, d->optind, d);
+      return;
+    }
+
+  /* Stable partition: slide the options down over the non-options and
+     put the non-options, saved on the side, after them.  The
+     `__getopt_nonoption_flags' string would have to follow the elements
+     around, which only `exchange' does.  A few runs kept inline are
+     merged in place instead.  */
+#if !(defined _LIBC && defined USE_NONOPTION_FLAGS)
+  if (runs != NULL)
+    nonopts = (char **) malloc (d->__npending * sizeof (char *));
+#endif
+  if (nonopts == NULL)
+    {
+      merge_runs (argv, d);
+      exchange (argv, d->optind, d);
+      return;
+    }
+
+  /* Traced as one exchange of all the pending non-options with all the
+     options among and after them, which is what it amounts to.  */
+  GETOPT_PROBE3 (getopt, exchange, runs[0], d->__npending,
+		 d->optind - runs[0] - d->__npending);
+
+  n = 0;
+  to = runs[0];
+  from = to;
+  for (i = 0; i < d->__nruns; i++)
+    {
+      for (; from < runs[2 * i]; from++)
+	argv[to++] = argv[from];
+      for (; from < runs[2 * i + 1]; from++)
+	nonopts[n++] = argv[from];
+    }
+  for (; from < d->optind; from++)
+    argv[to++] = argv[from];
+  memcpy (&argv[to], nonopts, n * sizeof (char *));
+  free (nonopts);
+
+  d->__first_nonopt = to;
+  d->__last_nonopt = d->optind;
+  free_runs (d);
 }
 
-/* Initialize the internal data when the first call is made.  */
+/* Initialize the internal data when the first call is made.
+   With a compiled SPEC, the ordering was already settled by `getopt_compile'
+   and OPTSTRING is returned unchanged.  */
 
 #if defined __STDC__ && __STDC__
-static const char *_getopt_initialize (int, char *const *, const char *);
+static const char *_getopt_initialize (int, char *const *, const char *,
+				       const struct getopt_spec *,
+				       struct getopt_state *);
 #endif
 static const char *
-_getopt_initialize (argc, argv, optstring)
+_getopt_initialize (argc, argv, optstring, spec, d)
      int argc;
      char *const *argv;
      const char *optstring;
+     const struct getopt_spec *spec;
+     struct getopt_state *d;
 {
   /* Start processing options with ARGV-element 1 (since ARGV-element 0
      is the program name); the sequence of previously skipped
      non-option ARGV-elements is empty.  */
 
-  first_nonopt = last_nonopt = optind;
+  d->__first_nonopt = d->__last_nonopt = d->optind;
+
+  d->__nextchar = NULL;
+  d->__end = NULL;
 
-  nextchar = NULL;
+  /* A scan that was abandoned half way may have left runs behind.  */
+  if (d->__initialized)
+    free_runs (d);
 
-  posixly_correct = getenv ("POSIXLY_CORRECT");
+  if (spec != NULL)
+    {
+      d->__posixly_correct = spec->posixly_correct;
+      d->__ordering = spec->ordering;
+      return optstring;
+    }
+
+  d->__posixly_correct = !!getenv ("POSIXLY_CORRECT");
 
   /* Determine how to handle the ordering of options and nonoptions.  */
 
   if (optstring[0] == '-')
     {
-      ordering = RETURN_IN_ORDER;
+      d->__ordering = RETURN_IN_ORDER;
       ++optstring;
     }
   else if (optstring[0] == '+')
     {
-      ordering = REQUIRE_ORDER;
+      d->__ordering = REQUIRE_ORDER;
       ++optstring;
     }
-  else if (posixly_correct != NULL)
-    ordering = REQUIRE_ORDER;
+  else if (d->__posixly_correct)
+    d->__ordering = REQUIRE_ORDER;
   else
-    ordering = PERMUTE;
+    d->__ordering = PERMUTE;
 
 #if defined _LIBC && defined USE_NONOPTION_FLAGS
-  if (posixly_correct == NULL
+  if (!d->__posixly_correct
       && argc == __libc_argc && argv == __libc_argv)
     {
       if (nonoption_flags_max_len == 0)
@@ -449,6 +649,296 @@ _getopt_initialize (argc, argv, optstring)
   return optstring;
 }
 
+/* Find the long option named by the NAMELEN characters at NAME, either
+   through MATCH, through INDEX or, if both are null, by testing all of
+   LONGOPTS for an exact match or abbreviated matches.  Returns the index
+   in LONGOPTS of the option found or -1, and sets *EXACT for an exact
+   match.  *AMBIG is set if NAME abbreviates more than one option; unless
+   STRICT, only options that differ in `has_arg', `flag' or `val' count as
+   different.  */
+
+#if defined __STDC__ && __STDC__
+static int find_long_option (const struct option *,
+			     const struct getopt_longindex *,
+			     getopt_longmatch *,
+			     const char *, size_t, int, int *, int *);
+#endif
+static int
+find_long_option (longopts, index, match, name, namelen, strict, exact, ambig)
+     const struct option *longopts;
+     const struct getopt_longindex *index;
+     getopt_longmatch *match;
+     const char *name;
+     size_t namelen;
+     int strict;
+     int *exact;
+     int *ambig;
+{
+  const struct option *p;
+  const struct option *pfound = NULL;
+  int indfound = -1;
+  int option_index;
+
+  if (match != NULL)
+    return (*match) (name, namelen, strict, exact, ambig);
+  if (index != NULL)
+    return _getopt_longindex_find (index, name, namelen, strict,
+				   exact, ambig);
+
+  *exact = 0;
+  *ambig = 0;
+  for (p = longopts, option_index = 0; p->name; p++, option_index++)
+    if (!strncmp (p->name, name, namelen))
+      {
+	if (namelen == strlen (p->name))
+	  {
+	    /* Exact match found.  */
+	    indfound = option_index;
+	    *exact = 1;
+	    break;
+	  }
+	else if (pfound == NULL)
+	  {
+	    /* First nonexact match found.  */
+	    pfound = p;
+	    indfound = option_index;
+	  }
+	else if (strict
+		 || pfound->has_arg != p->has_arg
+		 || pfound->flag != p->flag
+		 || pfound->val != p->val)
+	  /* Second or later nonexact match found.  */
+	  *ambig = 1;
+      }
+  return indfound;
+}
+
+/* The message for ERR, without suggestions.  */
+
+#if defined __STDC__ && __STDC__
+static int format_error (const struct getopt_error *, char *, size_t);
+#endif
+static int
+format_error (err, buf, size)
+     const struct getopt_error *err;
+     char *buf;
+     size_t size;
+{
+  int plen = (int) err->progname.len;
+  const char *prog = err->progname.ptr;
+  int olen = (int) err->option.len;
+  const char *opt = err->option.ptr;
+
+  switch (err->code)
+    {
+    case GETOPT_ERROR_UNKNOWN:
+      if (err->optchar == 0)
+	/* The option character or characters, and the name.  */
+	return snprintf (buf, size, _("%.*s: unrecognized option `%.*s%.*s'\n"),
+			 plen, prog, olen > 1 && opt[1] == '-' ? 2 : 1, opt,
+			 (int) err->name.len, err->name.ptr);
+      if (err->flags & GETOPT_ERROR_POSIX)
+	/* 1003.2 specifies the format of this message.  */
+	return snprintf (buf, size, _("%.*s: illegal option -- %c\n"),
+			 plen, prog, err->optchar);
+      return snprintf (buf, size, _("%.*s: invalid option -- %c\n"),
+		       plen, prog, err->optchar);
+
+    case GETOPT_ERROR_AMBIGUOUS:
+      if (err->flags & GETOPT_ERROR_W)
+	return snprintf (buf, size, _("%.*s: option `-W %.*s' is ambiguous\n"),
+			 plen, prog, olen, opt);
+      return snprintf (buf, size, _("%.*s: option `%.*s' is ambiguous\n"),
+		       plen, prog, olen, opt);
+
+    case GETOPT_ERROR_MISSING_ARG:
+      if (err->optchar != 0)
+	/* 1003.2 specifies the format of this message.  */
+	return snprintf (buf, size,
+			 _("%.*s: option requires an argument -- %c\n"),
+			 plen, prog, err->optchar);
+      return snprintf (buf, size, _("%.*s: option `%.*s' requires an argument\n"),
+		       plen, prog, olen, opt);
+
+    case GETOPT_ERROR_UNEXPECTED_ARG:
+      if (err->flags & GETOPT_ERROR_W)
+	return snprintf (buf, size, _("\
+%.*s: option `-W %s' doesn't allow an argument\n"),
+			 plen, prog, err->longopt->name);
+      if (olen > 1 && opt[1] == '-')
+	/* --option */
+	return snprintf (buf, size,
+			 _("%.*s: option `--%s' doesn't allow an argument\n"),
+			 plen, prog, err->longopt->name);
+      /* +option or -option */
+      return snprintf (buf, size,
+		       _("%.*s: option `%c%s' doesn't allow an argument\n"),
+		       plen, prog, opt[0], err->longopt->name);
+    }
+  return snprintf (buf, size, "%.*s: error\n", plen, prog);
+}
+
+int
+getopt_error_format (err, buf, size)
+     const struct getopt_error *err;
+     char *buf;
+     size_t size;
+{
+  int plen = (int) err->progname.len;
+  const char *opt = err->option.ptr;
+  const char *prefix;
+  int prefixlen;
+  int total;
+  int n;
+  int i;
+
+  total = format_error (err, buf, size);
+  if (total < 0 || err->nsuggestions == 0)
+    return total;
+
+  /* The suggestions are written the way the option was.  */
+  if (err->flags & GETOPT_ERROR_W)
+    prefix = "-W ", prefixlen = 3;
+  else if (err->option.len > 1 && opt[1] == '-')
+    prefix = "--", prefixlen = 2;
+  else
+    prefix = opt, prefixlen = 1;
+
+  /* Append to what fits, but count all of it.  */
+#define APPEND(args) \
+  do									      \
+    {									      \
+      n = snprintf args;						      \
+      if (n < 0)							      \
+	return n;							      \
+      total += n;							      \
+    }									      \
+  while (0)
+#define REST \
+  (size_t) total < size ? buf + total : NULL,				      \
+  (size_t) total < size ? size - total : 0
+
+  APPEND ((REST, _("%.*s: did you mean "), plen, err->progname.ptr));
+  for (i = 0; i < err->nsuggestions; i++)
+    APPEND ((REST, "`%.*s%s'%s", prefixlen, prefix, err->suggestions[i],
+	     i == err->nsuggestions - 1 ? "?\n"
+	     : i == err->nsuggestions - 2 ? _(" or ") : ", "));
+#undef APPEND
+#undef REST
+  return total;
+}
+
+/* Fill in the suggestions of ERR, an error about the long option
+   LONGOPTS did not resolve.  LONGINDEX, if not null, is the trie over
+   LONGOPTS.  */
+
+#if defined __STDC__ && __STDC__
+static void suggest (const struct getopt_nameindex *, const struct option *,
+		     const struct getopt_longindex *, struct getopt_error *);
+#endif
+static void
+suggest (index, longopts, longindex, err)
+     const struct getopt_nameindex *index;
+     const struct option *longopts;
+     const struct getopt_longindex *longindex;
+     struct getopt_error *err;
+{
+  const char *name = err->name.ptr;
+  size_t len;
+  int nearest[GETOPT_MAX_SUGGESTIONS];
+  int i, n;
+
+  for (len = 0; len < err->name.len && name[len] != '='; len++)
+    /* Do nothing.  */ ;
+
+  if (err->code == GETOPT_ERROR_AMBIGUOUS && longindex != NULL)
+    {
+      /* The first names it abbreviates, in the order of the names, from
+	 below its node in the trie.  */
+      n = _getopt_longindex_prefixed (longindex, name, len, nearest,
+				      GETOPT_MAX_SUGGESTIONS);
+      for (i = 0; i < n; i++)
+	err->suggestions[i] = longopts[nearest[i]].name;
+      err->nsuggestions = n;
+      return;
+    }
+  if (err->code == GETOPT_ERROR_AMBIGUOUS)
+    {
+      /* The names it abbreviates; the nearest ones by edit distance are
+	 usually just the short ones.  */
+      const struct option *p;
+
+      for (p = longopts;
+	   p->name != NULL && err->nsuggestions < GETOPT_MAX_SUGGESTIONS; p++)
+	if (!strncmp (p->name, name, len))
+	  {
+	    for (i = 0; i < err->nsuggestions; i++)
+	      if (!strcmp (err->suggestions[i], p->name))
+		break;
+	    if (i == err->nsuggestions)
+	      err->suggestions[err->nsuggestions++] = p->name;
+	  }
+      return;
+    }
+
+  /* Up to about a third of the letters wrong, and one in a short name.  */
+  n = getopt_nameindex_nearest (index, name, len,
+				len < 4 ? 1 : len < 8 ? 2 : 3,
+				nearest, GETOPT_MAX_SUGGESTIONS);
+  for (i = 0; i < n; i++)
+    err->suggestions[i] = _getopt_nameindex_name (index, nearest[i]);
+  err->nsuggestions = n;
+}
+
+/* Pass ERR to the `error' function of D, or else print it if
+   PRINT_ERRORS.  The message is written out in one piece.  */
+
+#if defined __STDC__ && __STDC__
+static void report_error (struct getopt_state *, int, const struct option *,
+			  const struct getopt_longindex *,
+			  struct getopt_error *);
+#endif
+static void
+report_error (d, print_errors, longopts, longindex, err)
+     struct getopt_state *d;
+     int print_errors;
+     const struct option *longopts;
+     const struct getopt_longindex *longindex;
+     struct getopt_error *err;
+{
+  char buf[256];
+  char *msg = buf;
+  int len;
+
+  if (d->nameindex != NULL && longopts != NULL && err->optchar == 0
+      && (err->code == GETOPT_ERROR_UNKNOWN
+	  || err->code == GETOPT_ERROR_AMBIGUOUS))
+    suggest (d->nameindex, longopts, longindex, err);
+
+  if (d->error != NULL)
+    {
+      d->error (d->error_cookie, err);
+      return;
+    }
+  if (!print_errors)
+    return;
+
+  len = getopt_error_format (err, buf, sizeof buf);
+  if (len < 0)
+    return;
+  if ((size_t) len >= sizeof buf)
+    {
+      msg = (char *) malloc (len + 1);
+      if (msg != NULL)
+	getopt_error_format (err, msg, len + 1);
+      else
+	msg = buf;
+    }
+  fputs (msg, stderr);
+  if (msg != buf)
+    free (msg);
+}
+
 /* Scan elements of ARGV (whose length is ARGC) for option characters
    given in OPTSTRING.
 
@@ -503,32 +993,131 @@ _getopt_initialize (argc, argv, optstring)
    recent call.
 
    If LONG_ONLY is nonzero, '-' as well as '--' can introduce
-   long-named options.  */
+   long-named options.
+
+   All of the scan state, including the results that the global interface
+   reports through `optind', `optarg' and `optopt', is kept in D.
+
+   If SPEC is not null, OPTSTRING and LONGOPTS are the ones it was compiled
+   from, and the option characters, the ordering and the long-option index
+   are taken from it instead of being worked out on every call.  */
+
+/* Flags of the short option character C; see getopt_int.h.  */
+#define SHORT_FLAGS(c) \
+  (spec != NULL ? spec->shortopts[(unsigned char) (c)]			      \
+   : _getopt_short_flags (my_index (optstring, (c))))
+
+/* The ARGV-elements are the strings of ARGV, or else the length-delimited
+   VIEWS, which need not be NUL-terminated; see `getopt_long_view_r'.
+   ARG_CHAR reads '\0' past the end of an element, and is never used
+   beyond the first '\0' of an element that has one.  */
+#define ARG(i) (views != NULL ? (char *) views[i].ptr : argv[i])
+#define ARG_END(i) (views != NULL ? (char *) views[i].ptr + views[i].len : NULL)
+#define ARG_CHAR(i, k) \
+  (views != NULL ? ((size_t) (k) < views[i].len ? views[i].ptr[k] : '\0')     \
+   : argv[i][k])
+
+/* Whether P, in the element being decoded, is at its end.  */
+#define AT_END(p) (d->__end != NULL ? (p) == d->__end : *(p) == '\0')
+
+/* The length of element I, and of the rest of the element being decoded
+   from P on.  */
+#define ARG_LEN(i) (views != NULL ? views[i].len : strlen (argv[i]))
+#define REST_LEN(p) \
+  (d->__end != NULL ? (size_t) (d->__end - (p)) : strlen (p))
+
+/* Describe an error of kind CODE about the LEN bytes at OPT, in element
+   ARGIND (see `struct getopt_error'), to the `error' function of D, or
+   print it if PRINT_ERRORS.  */
+#define REPORT(CODE, FLAGS, ARGIND, OPT, LEN, OPTCHAR, LONGOPT) \
+  do									      \
+    if (d->error != NULL || print_errors)				      \
+      {									      \
+	struct getopt_error err;					      \
+	err.code = (CODE);						      \
+	err.flags = ((FLAGS)						      \
+		     | (d->__posixly_correct ? GETOPT_ERROR_POSIX : 0));	      \
+	err.argind = (ARGIND) + d->__argbase;				      \
+	err.progname.ptr = ARG (0);					      \
+	err.progname.len = ARG_LEN (0);					      \
+	err.option.ptr = (OPT);						      \
+	err.option.len = (LEN);						      \
+	err.name.ptr = (OPTCHAR) != 0 ? NULL : d->__nextchar;		      \
+	err.name.len = (OPTCHAR) != 0 ? 0 : REST_LEN (d->__nextchar);	      \
+	err.optchar = (OPTCHAR);					      \
+	err.longopt = (LONGOPT);					      \
+	err.nsuggestions = 0;						      \
+	report_error (d, print_errors, longopts,			      \
+		      spec != NULL ? spec->longindex : d->longindex, &err);   \
+      }									      \
+  while (0)
+
+/* Step past the rest of the element being decoded.  */
+#define SKIP_REST() \
+  (d->__nextchar = (d->__end != NULL ? d->__end				      \
+		    : d->__nextchar + strlen (d->__nextchar)))
+
+/* Make the rest of the element being decoded from P, or all of element I,
+   the argument of the option.  */
+#define OPTARG_REST(p) \
+  (d->optarg = (p),							      \
+   d->optarglen = d->__end != NULL ? (size_t) (d->__end - (p)) : 0)
+#define OPTARG_ARG(i) \
+  (d->optarg = ARG (i), d->optarglen = views != NULL ? views[i].len : 0)
+
+/* A scan over VIEWS cannot move them, and one with `operands' set must
+   not; the non-options are then listed, or just passed over.  */
+#define NOPERMUTE (views != NULL || d->operands != NULL)
+
+/* Pass over the non-option at `optind', listing it in `operands'.  */
+#define PASS_OPERAND() \
+  ((d->operands != NULL							      \
+    ? (void) (d->operands[d->noperands++] = d->optind) : (void) 0),	      \
+   d->optind++)
 
-int
-_getopt_internal (argc, argv, optstring, longopts, longind, long_only)
+#if defined __STDC__ && __STDC__
+static int scan_option (int, char *const *, const struct getopt_view *,
+			const char *, const struct option *,
+			const struct getopt_spec *, int *, int,
+			struct getopt_state *);
+#endif
+static int
+scan_option (argc, argv, views, optstring, longopts, spec, longind, long_only,
+	     d)
      int argc;
      char *const *argv;
+     const struct getopt_view *views;
      const char *optstring;
      const struct option *longopts;
+     const struct getopt_spec *spec;
      int *longind;
      int long_only;
+     struct getopt_state *d;
 {
-  int print_errors = opterr;
-  if (optstring[0] == ':')
+  int print_errors = d->opterr;
+  int norecord = long_only & _GETOPT_NORECORD;
+  /* Whether OPTSTRING asks for `:' rather than `?' on a missing argument,
+     worked out before it loses its leading `-' or `+' so that every call
+     and the compiled SPEC agree.  */
+  int colon = spec != NULL ? spec->colon : _getopt_colon_p (optstring);
+  if (colon)
     print_errors = 0;
 
+  long_only &= ~_GETOPT_NORECORD;
   if (argc < 1)
     return -1;
 
-  optarg = NULL;
+  d->optarg = NULL;
 
-  if (optind == 0 || !__getopt_initialized)
+  if (d->optind == 0 || !d->__initialized)
     {
-      if (optind == 0)
-	optind = 1;	/* Don't scan ARGV[0], the program name.  */
-      optstring = _getopt_initialize (argc, argv, optstring);
-      __getopt_initialized = 1;
+      if (d->optind == 0)
+	d->optind = 1;	/* Don't scan ARGV[0], the program name.  */
+      optstring = _getopt_initialize (argc, argv, optstring, spec, d);
+      d->__initialized = 1;
+      if (!norecord && getopt_recording ())
+	_getopt_record_scan (argc, argv, views, optstring, longopts,
+			     long_only, d);
     }
 
   /* Test whether ARGV[optind] points to a non-option argument.
@@ -536,40 +1125,88 @@ _getopt_internal (argc, argv, optstring, longopts, longind, long_only)
      from the shell indicating it is not an option.  The later information
      is only used when the used in the GNU libc.  */
 #if defined _LIBC && defined USE_NONOPTION_FLAGS
-# define NONOPTION_P (argv[optind][0] != '-' || argv[optind][1] == '\0'	      \
-		      || (optind < nonoption_flags_len			      \
-			  && __getopt_nonoption_flags[optind] == '1'))
+# define NONOPTION_P (ARG_CHAR (d->optind, 0) != '-'			      \
+		      || ARG_CHAR (d->optind, 1) == '\0'			      \
+		      || (d->optind < nonoption_flags_len		      \
+			  && __getopt_nonoption_flags[d->optind] == '1'))
 #else
-# define NONOPTION_P (argv[optind][0] != '-' || argv[optind][1] == '\0')
+# define NONOPTION_P (ARG_CHAR (d->optind, 0) != '-'			      \
+		      || ARG_CHAR (d->optind, 1) == '\0')
 #endif
 
-  if (nextchar == NULL || *nextchar == '\0')
+  if (d->__nextchar == NULL || AT_END (d->__nextchar))
     {
       /* Advance to the next ARGV-element.  */
 
       /* Give FIRST_NONOPT & LAST_NONOPT rational values if OPTIND has been
 	 moved back by the user (who may also have changed the arguments).  */
-      if (last_nonopt > optind)
-	last_nonopt = optind;
-      if (first_nonopt > optind)
-	first_nonopt = optind;
+      if (d->__nruns && d->__last_nonopt > d->optind)
+	{
+	  int *runs = RUNS (d);
 
-      if (ordering == PERMUTE)
+	  while (d->__nruns && runs[2 * d->__nruns - 2] >= d->optind)
+	    {
+	      d->__nruns--;
+	      d->__npending -= (runs[2 * d->__nruns + 1]
+				- runs[2 * d->__nruns]);
+	    }
+	  if (d->__nruns && runs[2 * d->__nruns - 1] > d->optind)
+	    {
+	      d->__npending -= runs[2 * d->__nruns - 1] - d->optind;
+	      runs[2 * d->__nruns - 1] = d->optind;
+	    }
+	  if (d->__nruns)
+	    d->__last_nonopt = runs[2 * d->__nruns - 1];
+	  if (d->__nruns <= 1)
+	    free_runs (d);
+	}
+      if (d->__last_nonopt > d->optind)
+	d->__last_nonopt = d->optind;
+      if (d->__first_nonopt > d->optind)
+	d->__first_nonopt = d->optind;
+      if (d->operands != NULL)
+	while (d->noperands > 0
+	       && d->operands[d->noperands - 1] >= d->optind)
+	  d->noperands--;
+
+      if (d->__ordering == PERMUTE && NOPERMUTE)
 	{
-	  /* If we have just processed some options following some non-options,
-	     exchange them so that the options come first.  */
+	  /* ARGV must not be touched: list the non-options instead of
+	     moving them, so that there is never anything to permute.  */
 
-	  if (first_nonopt != last_nonopt && last_nonopt != optind)
-	    exchange ((char **) argv);
-	  else if (last_nonopt != optind)
-	    first_nonopt = optind;
+	  while (d->optind < argc && NONOPTION_P)
+	    PASS_OPERAND ();
+	  d->__first_nonopt = d->__last_nonopt = d->optind;
+	}
+      else if (d->__ordering == PERMUTE)
+	{
+	  int start;
+
+	  /* If we have just processed some options following some
+	     non-options, they will have to come first; that is left to
+	     `permute_pending' at the end of the scan.  */
+
+	  if (d->__first_nonopt == d->__last_nonopt
+	      && d->__last_nonopt != d->optind)
+	    d->__first_nonopt = d->__last_nonopt = d->optind;
 
 	  /* Skip any additional non-options
 	     and extend the range of non-options previously skipped.  */
 
-	  while (optind < argc && NONOPTION_P)
-	    optind++;
-	  last_nonopt = optind;
+	  start = d->optind;
+	  while (d->optind < argc && NONOPTION_P)
+	    d->optind++;
+	  if (d->optind != start)
+	    {
+	      if (start != d->__last_nonopt)
+		record_run ((char **) argv, start, d->optind, d);
+	      else if (d->__nruns)
+		{
+		  RUNS (d)[2 * d->__nruns - 1] = d->optind;
+		  d->__npending += d->optind - start;
+		}
+	      d->__last_nonopt = d->optind;
+	    }
 	}
 
       /* The special ARGV-element `--' means premature end of options.
@@ -577,28 +1214,40 @@ _getopt_internal (argc, argv, optstring, longopts, longind, long_only)
 	 then exchange with previous non-options as if it were an option,
 	 then skip everything else like a non-option.  */
 
-      if (optind != argc && !strcmp (argv[optind], "--"))
+      if (d->optind != argc
+	  && (views != NULL
+	      ? views[d->optind].len == 2 && !memcmp (views[d->optind].ptr, "--", 2)
+	      : !strcmp (argv[d->optind], "--")))
 	{
-	  optind++;
+	  d->optind++;
 
-	  if (first_nonopt != last_nonopt && last_nonopt != optind)
-	    exchange ((char **) argv);
-	  else if (first_nonopt == last_nonopt)
-	    first_nonopt = optind;
-	  last_nonopt = argc;
+	  if (NOPERMUTE)
+	    {
+	      while (d->optind < argc)
+		PASS_OPERAND ();
+	      d->__first_nonopt = argc;
+	    }
+	  else if (d->__first_nonopt != d->__last_nonopt)
+	    permute_pending ((char **) argv, d);
+	  else
+	    d->__first_nonopt = d->optind;
+	  d->__last_nonopt = argc;
 
-	  optind = argc;
+	  d->optind = argc;
 	}
 
       /* If we have done all the ARGV-elements, stop the scan
 	 and back over any non-options that we skipped and permuted.  */
 
-      if (optind == argc)
+      if (d->optind == argc)
 	{
+	  if (d->__ordering == PERMUTE)
+	    permute_pending ((char **) argv, d);
+
 	  /* Set the next-arg-index to point at the non-options
 	     that we previously skipped, so the caller will digest them.  */
-	  if (first_nonopt != last_nonopt)
-	    optind = first_nonopt;
+	  if (d->__first_nonopt != d->__last_nonopt)
+	    d->optind = d->__first_nonopt;
 	  return -1;
 	}
 
@@ -607,17 +1256,29 @@ _getopt_internal (argc, argv, optstring, longopts, longind, long_only)
 
       if (NONOPTION_P)
 	{
-	  if (ordering == REQUIRE_ORDER)
-	    return -1;
-	  optarg = argv[optind++];
+	  if (d->__ordering == REQUIRE_ORDER)
+	    {
+	      if (NOPERMUTE)
+		while (d->optind < argc)
+		  PASS_OPERAND ();
+	      return -1;
+	    }
+	  d->__argind = d->optind;
+	  OPTARG_ARG (d->optind);
+	  d->optind++;
 	  return 1;
 	}
 
       /* We have found another option-ARGV-element.
-	 Skip the initial punctuation.  */
-
-      nextchar = (argv[optind] + 1
-		  + (longopts != NULL && argv[optind][1] == '-'));
+	 Skip the initial punctuation.  Options end up in front of the
+	 non-options skipped so far, which is where this element will be
+	 once the scan is over.  */
+
+      d->__argind = (d->__ordering == PERMUTE
+		     ? d->optind - PENDING_NONOPTS (d) : d->optind);
+      d->__nextchar = (ARG (d->optind) + 1
+		       + (longopts != NULL && ARG_CHAR (d->optind, 1) == '-'));
+      d->__end = ARG_END (d->optind);
     }
 
   /* Decode the current option-ARGV-element.  */
@@ -636,107 +1297,85 @@ _getopt_internal (argc, argv, optstring, longopts, longind, long_only)
      This distinction seems to be the most useful approach.  */
 
   if (longopts != NULL
-      && (argv[optind][1] == '-'
-	  || (long_only && (argv[optind][2] || !my_index (optstring, argv[optind][1])))))
+      && (ARG_CHAR (d->optind, 1) == '-'
+	  || (long_only && (ARG_CHAR (d->optind, 2)
+			    || !(SHORT_FLAGS (ARG_CHAR (d->optind, 1))
+				 & SHORT_LISTED)))))
     {
       char *nameend;
-      const struct option *p;
       const struct option *pfound = NULL;
       int exact = 0;
       int ambig = 0;
-      int indfound = -1;
+      int indfound;
       int option_index;
 
-      for (nameend = nextchar; *nameend && *nameend != '='; nameend++)
+      for (nameend = d->__nextchar; !AT_END (nameend) && *nameend != '=';
+	   nameend++)
 	/* Do nothing.  */ ;
 
-      /* Test all long options for either exact match
-	 or abbreviated matches.  */
-      for (p = longopts, option_index = 0; p->name; p++, option_index++)
-	if (!strncmp (p->name, nextchar, nameend - nextchar))
-	  {
-	    if ((unsigned int) (nameend - nextchar)
-		== (unsigned int) strlen (p->name))
-	      {
-		/* Exact match found.  */
-		pfound = p;
-		indfound = option_index;
-		exact = 1;
-		break;
-	      }
-	    else if (pfound == NULL)
-	      {
-		/* First nonexact match found.  */
-		pfound = p;
-		indfound = option_index;
-	      }
-	    else if (long_only
-		     || pfound->has_arg != p->has_arg
-		     || pfound->flag != p->flag
-		     || pfound->val != p->val)
-	      /* Second or later nonexact match found.  */
-	      ambig = 1;
-	  }
+      indfound = find_long_option (longopts,
+				   spec != NULL ? spec->longindex : d->longindex,
+				   spec != NULL ? spec->longmatch : NULL,
+				   d->__nextchar,
+				   nameend - d->__nextchar, long_only,
+				   &exact, &ambig);
+      if (indfound >= 0)
+	pfound = &longopts[indfound];
 
       if (ambig && !exact)
 	{
-	  if (print_errors)
-	    fprintf (stderr, _("%s: option `%s' is ambiguous\n"),
-		     argv[0], argv[optind]);
-	  nextchar += strlen (nextchar);
-	  optind++;
-	  optopt = 0;
+	  GETOPT_PROBE2 (getopt, long__ambiguous, d->__nextchar,
+			 nameend - d->__nextchar);
+	  REPORT (GETOPT_ERROR_AMBIGUOUS, 0, d->optind,
+		  ARG (d->optind), ARG_LEN (d->optind), 0, NULL);
+	  SKIP_REST ();
+	  d->optind++;
+	  d->optopt = 0;
 	  return '?';
 	}
 
       if (pfound != NULL)
 	{
+	  GETOPT_PROBE4 (getopt, long__match, d->__nextchar,
+			 nameend - d->__nextchar, indfound, exact);
 	  option_index = indfound;
-	  optind++;
-	  if (*nameend)
+	  d->optind++;
+	  if (!AT_END (nameend))
 	    {
 	      /* Don't test has_arg with >, because some C compilers don't
 		 allow it to be used on enums.  */
 	      if (pfound->has_arg)
-		optarg = nameend + 1;
+		OPTARG_REST (nameend + 1);
 	      else
 		{
-		  if (print_errors)
-		    {
-		      if (argv[optind - 1][1] == '-')
-			/* --option */
-			fprintf (stderr,
-				 _("%s: option `--%s' doesn't allow an argument\n"),
-				 argv[0], pfound->name);
-		      else
-			/* +option or -option */
-			fprintf (stderr,
-				 _("%s: option `%c%s' doesn't allow an argument\n"),
-				 argv[0], argv[optind - 1][0], pfound->name);
-		    }
-
-		  nextchar += strlen (nextchar);
-
-		  optopt = pfound->val;
+		  REPORT (GETOPT_ERROR_UNEXPECTED_ARG, 0, d->optind - 1,
+			  ARG (d->optind - 1), ARG_LEN (d->optind - 1),
+			  0, pfound);
+
+		  SKIP_REST ();
+
+		  d->optopt = pfound->val;
 		  return '?';
 		}
 	    }
 	  else if (pfound->has_arg == 1)
 	    {
-	      if (optind < argc)
-		optarg = argv[optind++];
+	      if (d->optind < argc)
+		{
+		  OPTARG_ARG (d->optind);
+		  d->optind++;
+		}
 	      else
 		{
-		  if (print_errors)
-		    fprintf (stderr,
-			   _("%s: option `%s' requires an argument\n"),
-			   argv[0], argv[optind - 1]);
-		  nextchar += strlen (nextchar);
-		  optopt = pfound->val;
-		  return optstring[0] == ':' ? ':' : '?';
+		  REPORT (GETOPT_ERROR_MISSING_ARG, 0, d->optind - 1,
+			  ARG (d->optind - 1), ARG_LEN (d->optind - 1),
+			  0, pfound);
+		  SKIP_REST ();
+		  d->optopt = pfound->val;
+		  return colon ? ':' : '?';
 		}
 	    }
-	  nextchar += strlen (nextchar);
+	  SKIP_REST ();
 	  if (longind != NULL)
 	    *longind = option_index;
 	  if (pfound->flag)
@@ -751,23 +1390,14 @@ _getopt_internal (argc, argv, optstring, longopts, longind, long_only)
 	 or the option starts with '--' or is not a valid short
 	 option, then it's an error.
 	 Otherwise interpret it as a short option.  */
-      if (!long_only || argv[optind][1] == '-'
-	  || my_index (optstring, *nextchar) == NULL)
+      if (!long_only || ARG_CHAR (d->optind, 1) == '-'
+	  || !(SHORT_FLAGS (*d->__nextchar) & SHORT_LISTED))
 	{
-	  if (print_errors)
-	    {
-	      if (argv[optind][1] == '-')
-		/* --option */
-		fprintf (stderr, _("%s: unrecognized option `--%s'\n"),
-			 argv[0], nextchar);
-	      else
-		/* +option or -option */
-		fprintf (stderr, _("%s: unrecognized option `%c%s'\n"),
-			 argv[0], argv[optind][0], nextchar);
-	    }
-	  nextchar = (char *) "";
-	  optind++;
-	  optopt = 0;
+	  REPORT (GETOPT_ERROR_UNKNOWN, 0, d->optind,
+		  ARG (d->optind), ARG_LEN (d->optind), 0, NULL);
+	  SKIP_REST ();
+	  d->optind++;
+	  d->optopt = 0;
 	  return '?';
 	}
     }
@@ -775,140 +1405,123 @@ _getopt_internal (argc, argv, optstring, longopts, longind, long_only)
   /* Look at and handle the next short option-character.  */
 
   {
-    char c = *nextchar++;
-    char *temp = my_index (optstring, c);
+    char c = *d->__nextchar++;
+    int flags = SHORT_FLAGS (c);
+    int elt = d->optind;	/* The element C is in.  */
 
     /* Increment `optind' when we start to process its last character.  */
-    if (*nextchar == '\0')
-      ++optind;
+    if (AT_END (d->__nextchar))
+      ++d->optind;
 
-    if (temp == NULL || c == ':')
+    if (!(flags & SHORT_LISTED) || c == ':')
       {
-	if (print_errors)
-	  {
-	    if (posixly_correct)
-	      /* 1003.2 specifies the format of this message.  */
-	      fprintf (stderr, _("%s: illegal option -- %c\n"),
-		       argv[0], c);
-	    else
-	      fprintf (stderr, _("%s: invalid option -- %c\n"),
-		       argv[0], c);
-	  }
-	optopt = c;
+	REPORT (GETOPT_ERROR_UNKNOWN, 0, elt,
+		d->__nextchar - 1, 1, c, NULL);
+	d->optopt = c;
 	return '?';
       }
     /* Convenience. Treat POSIX -W foo same as long option --foo */
-    if (temp[0] == 'W' && temp[1] == ';')
+    if ((flags & SHORT_W) && longopts != NULL)
       {
 	char *nameend;
-	const struct option *p;
 	const struct option *pfound = NULL;
 	int exact = 0;
 	int ambig = 0;
-	int indfound = 0;
+	int indfound;
 	int option_index;
 
 	/* This is an option that requires an argument.  */
-	if (*nextchar != '\0')
+	if (!AT_END (d->__nextchar))
 	  {
-	    optarg = nextchar;
+	    OPTARG_REST (d->__nextchar);
 	    /* If we end this ARGV-element by taking the rest as an arg,
 	       we must advance to the next element now.  */
-	    optind++;
+	    d->optind++;
 	  }
-	else if (optind == argc)
+	else if (d->optind == argc)
 	  {
-	    if (print_errors)
-	      {
-		/* 1003.2 specifies the format of this message.  */
-		fprintf (stderr, _("%s: option requires an argument -- %c\n"),
-			 argv[0], c);
-	      }
-	    optopt = c;
-	    if (optstring[0] == ':')
+	    REPORT (GETOPT_ERROR_MISSING_ARG, GETOPT_ERROR_W, elt,
+		    d->__nextchar - 1, 1, c, NULL);
+	    d->optopt = c;
+	    if (colon)
 	      c = ':';
 	    else
 	      c = '?';
 	    return c;
 	  }
 	else
-	  /* We already incremented `optind' once;
-	     increment it again when taking next ARGV-elt as argument.  */
-	  optarg = argv[optind++];
+	  {
+	    /* We already incremented `optind' once;
+	       increment it again when taking next ARGV-elt as argument.  */
+	    OPTARG_ARG (d->optind);
+	    d->__end = ARG_END (d->optind);
+	    d->optind++;
+	  }
 
 	/* optarg is now the argument, see if it's in the
 	   table of longopts.  */
 
-	for (nextchar = nameend = optarg; *nameend && *nameend != '='; nameend++)
+	for (d->__nextchar = nameend = d->optarg;
+	     !AT_END (nameend) && *nameend != '='; nameend++)
 	  /* Do nothing.  */ ;
 
-	/* Test all long options for either exact match
-	   or abbreviated matches.  */
-	for (p = longopts, option_index = 0; p->name; p++, option_index++)
-	  if (!strncmp (p->name, nextchar, nameend - nextchar))
-	    {
-	      if ((unsigned int) (nameend - nextchar) == strlen (p->name))
-		{
-		  /* Exact match found.  */
-		  pfound = p;
-		  indfound = option_index;
-		  exact = 1;
-		  break;
-		}
-	      else if (pfound == NULL)
-		{
-		  /* First nonexact match found.  */
-		  pfound = p;
-		  indfound = option_index;
-		}
-	      else
-		/* Second or later nonexact match found.  */
-		ambig = 1;
-	    }
+	/* Unlike `--', any two abbreviated matches are ambiguous here.  */
+	indfound = find_long_option (longopts,
+				     spec != NULL
+				     ? spec->longindex : d->longindex,
+				     spec != NULL ? spec->longmatch : NULL,
+				     d->__nextchar,
+				     nameend - d->__nextchar, 1,
+				     &exact, &ambig);
+	if (indfound >= 0)
+	  pfound = &longopts[indfound];
 	if (ambig && !exact)
 	  {
-	    if (print_errors)
-	      fprintf (stderr, _("%s: option `-W %s' is ambiguous\n"),
-		       argv[0], argv[optind]);
-	    nextchar += strlen (nextchar);
-	    optind++;
+	    GETOPT_PROBE2 (getopt, long__ambiguous, d->__nextchar,
+			   nameend - d->__nextchar);
+	    REPORT (GETOPT_ERROR_AMBIGUOUS, GETOPT_ERROR_W, d->optind - 1,
+		    d->__nextchar, REST_LEN (d->__nextchar), 0, NULL);
+	    SKIP_REST ();
 	    return '?';
 	  }
 	if (pfound != NULL)
 	  {
+	    GETOPT_PROBE4 (getopt, long__match, d->__nextchar,
+			   nameend - d->__nextchar, indfound, exact);
 	    option_index = indfound;
-	    if (*nameend)
+	    if (!AT_END (nameend))
 	      {
 		/* Don't test has_arg with >, because some C compilers don't
 		   allow it to be used on enums.  */
 		if (pfound->has_arg)
-		  optarg = nameend + 1;
+		  OPTARG_REST (nameend + 1);
 		else
 		  {
-		    if (print_errors)
-		      fprintf (stderr, _("\
-%s: option `-W %s' doesn't allow an argument\n"),
-			       argv[0], pfound->name);
+		    REPORT (GETOPT_ERROR_UNEXPECTED_ARG, GETOPT_ERROR_W,
+			    d->optind - 1, d->__nextchar,
+			    REST_LEN (d->__nextchar), 0, pfound);
 
-		    nextchar += strlen (nextchar);
+		    SKIP_REST ();
 		    return '?';
 		  }
 	      }
 	    else if (pfound->has_arg == 1)
 	      {
-		if (optind < argc)
-		  optarg = argv[optind++];
+		if (d->optind < argc)
+		  {
+		    OPTARG_ARG (d->optind);
+		    d->optind++;
+		  }
 		else
 		  {
-		    if (print_errors)
-		      fprintf (stderr,
-			       _("%s: option `%s' requires an argument\n"),
-			       argv[0], argv[optind - 1]);
-		    nextchar += strlen (nextchar);
-		    return optstring[0] == ':' ? ':' : '?';
+		    REPORT (GETOPT_ERROR_MISSING_ARG, GETOPT_ERROR_W,
+			    d->optind - 1, ARG (d->optind - 1),
+			    ARG_LEN (d->optind - 1), 0, pfound);
+		    SKIP_REST ();
+		    return colon ? ':' : '?';
 		  }
 	      }
-	    nextchar += strlen (nextchar);
+	    SKIP_REST ();
 	    if (longind != NULL)
 	      *longind = option_index;
 	    if (pfound->flag)
@@ -918,59 +1531,154 @@ _getopt_internal (argc, argv, optstring, longopts, longind, long_only)
 	      }
 	    return pfound->val;
 	  }
-	  nextchar = NULL;
+	  d->__nextchar = NULL;
 	  return 'W';	/* Let the application handle it.   */
       }
-    if (temp[1] == ':')
+    if (flags & SHORT_ARG)
       {
-	if (temp[2] == ':')
+	if (flags & SHORT_OPTIONAL)
 	  {
 	    /* This is an option that accepts an argument optionally.  */
-	    if (*nextchar != '\0')
+	    if (!AT_END (d->__nextchar))
 	      {
-		optarg = nextchar;
-		optind++;
+		OPTARG_REST (d->__nextchar);
+		d->optind++;
 	      }
 	    else
-	      optarg = NULL;
-	    nextchar = NULL;
+	      d->optarg = NULL;
+	    d->__nextchar = NULL;
 	  }
 	else
 	  {
 	    /* This is an option that requires an argument.  */
-	    if (*nextchar != '\0')
+	    if (!AT_END (d->__nextchar))
 	      {
-		optarg = nextchar;
+		OPTARG_REST (d->__nextchar);
 		/* If we end this ARGV-element by taking the rest as an arg,
 		   we must advance to the next element now.  */
-		optind++;
+		d->optind++;
 	      }
-	    else if (optind == argc)
+	    else if (d->optind == argc)
 	      {
-		if (print_errors)
-		  {
-		    /* 1003.2 specifies the format of this message.  */
-		    fprintf (stderr,
-			     _("%s: option requires an argument -- %c\n"),
-			     argv[0], c);
-		  }
-		optopt = c;
-		if (optstring[0] == ':')
+		REPORT (GETOPT_ERROR_MISSING_ARG, 0, elt,
+			d->__nextchar - 1, 1, c, NULL);
+		d->optopt = c;
+		if (colon)
 		  c = ':';
 		else
 		  c = '?';
 	      }
 	    else
-	      /* We already incremented `optind' once;
-		 increment it again when taking next ARGV-elt as argument.  */
-	      optarg = argv[optind++];
-	    nextchar = NULL;
+	      {
+		/* We already incremented `optind' once;
+		   increment it again when taking next ARGV-elt as argument.  */
+		OPTARG_ARG (d->optind);
+		d->optind++;
+	      }
+	    d->__nextchar = NULL;
 	  }
       }
     return c;
   }
 }
 
+/* Every entry point scans through here, between the probes.  */
+
+#if defined __STDC__ && __STDC__
+static int getopt_scan (int, char *const *, const struct getopt_view *,
+			const char *, const struct option *,
+			const struct getopt_spec *, int *, int,
+			struct getopt_state *);
+#endif
+static int
+getopt_scan (argc, argv, views, optstring, longopts, spec, longind, long_only,
+	     d)
+     int argc;
+     char *const *argv;
+     const struct getopt_view *views;
+     const char *optstring;
+     const struct option *longopts;
+     const struct getopt_spec *spec;
+     int *longind;
+     int long_only;
+     struct getopt_state *d;
+{
+  int result;
+
+  GETOPT_PROBE2 (getopt, option__entry, argc, d->optind);
+  result = scan_option (argc, argv, views, optstring, longopts, spec,
+			longind, long_only, d);
+  GETOPT_PROBE2 (getopt, option__return, result, d->optind);
+  return result;
+}
+
+int
+_getopt_internal_r (argc, argv, optstring, longopts, longind, long_only, d)
+     int argc;
+     char *const *argv;
+     const char *optstring;
+     const struct option *longopts;
+     int *longind;
+     int long_only;
+     struct getopt_state *d;
+{
+  return getopt_scan (argc, argv, NULL, optstring, longopts, NULL,
+		      longind, long_only, d);
+}
+
+int
+_getopt_spec_internal_r (argc, argv, spec, longind, long_only, d)
+     int argc;
+     char *const *argv;
+     const struct getopt_spec *spec;
+     int *longind;
+     int long_only;
+     struct getopt_state *d;
+{
+  return getopt_scan (argc, argv, NULL, spec->optstring, spec->longopts,
+		      spec, longind, long_only, d);
+}
+
+int
+_getopt_view_internal_r (argc, views, spec, longind, long_only, d)
+     int argc;
+     const struct getopt_view *views;
+     const struct getopt_spec *spec;
+     int *longind;
+     int long_only;
+     struct getopt_state *d;
+{
+  return getopt_scan (argc, NULL, views, spec->optstring, spec->longopts,
+		      spec, longind, long_only, d);
+}
+
+#ifndef ELIDE_CODE
+
+int
+_getopt_internal (argc, argv, optstring, longopts, longind, long_only)
+     int argc;
+     char *const *argv;
+     const char *optstring;
+     const struct option *longopts;
+     int *longind;
+     int long_only;
+{
+  int result;
+
+  getopt_data.optind = optind;
+  getopt_data.opterr = opterr;
+  getopt_data.optopt = optopt;
+
+  result = _getopt_internal_r (argc, argv, optstring, longopts,
+			       longind, long_only, &getopt_data);
+
+  optind = getopt_data.optind;
+  optarg = getopt_data.optarg;
+  optopt = getopt_data.optopt;
+
+  return result;
+}
+
 int
 getopt (argc, argv, optstring)
      int argc;
@@ -984,6 +1692,27 @@ getopt (argc, argv, optstring)
 }
 
 #endif	/* Not ELIDE_CODE.  */
+
+int
+getopt_r (argc, argv, optstring, d)
+     int argc;
+     char *const *argv;
+     const char *optstring;
+     struct getopt_state *d;
+{
+  return _getopt_internal_r (argc, argv, optstring,
+			     (const struct option *) 0,
+			     (int *) 0,
+			     0, d);
+}
+
+void
+getopt_state_release (d)
+     struct getopt_state *d;
+{
+  free_runs (d);
+}
+
 #ifdef TEST
 
 /* Compile with -DTEST to make an executable for use in testing
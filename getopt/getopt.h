@@ -34,6 +34,9 @@
 # include <ctype.h>
 #endif
 
+/* For `size_t' in `struct getopt_view'.  */
+#include <stddef.h>
+
 #ifdef WIN32
 # ifdef DLL_EXPORTS
 #  define EXPORTS_API _declspec(dllexport)
@@ -79,6 +82,140 @@ extern EXPORTS_API int opterr;
 
 extern EXPORTS_API int optopt;
 
+/* The reentrant interface (`getopt_r', `getopt_long_r' and
+   `getopt_long_only_r') keeps everything that the functions above keep
+   in globals in one of these, so that any number of scans can run at
+   the same time, e.g. one per thread.
+
+   `optind', `opterr', `optopt' and `optarg' have exactly the meaning of
+   the global variables of the same name.  The members starting with `__'
+   are private to getopt.  Initialize a fresh state with
+   GETOPT_STATE_INITIALIZER; setting `optind' back to zero restarts the
+   scan, just like with the global interface.  A scan in PERMUTE order
+   whose options and non-options interleave more than a few times holds
+   some memory from then until it returns -1 or is restarted; call
+   `getopt_state_release' if the scan is given up before that.  Any of
+   the `_r' functions may take it, and none does for a command line with
+   up to _GETOPT_INLINE_RUNS separate runs of non-options.  */
+
+/* The runs of non-options a scan keeps track of inside its state before
+   it allocates room for more.  */
+#define _GETOPT_INLINE_RUNS	4
+
+struct getopt_commands;
+struct getopt_longindex;
+struct getopt_nameindex;
+struct getopt_respfile;
+struct getopt_spec;
+struct option;
+
+/* An ARGV-element given as the LEN bytes at PTR, which need not be
+   followed by a NUL.  */
+struct getopt_view
+{
+  const char *ptr;
+  size_t len;
+};
+
+/* What an error found by a scan is about.  */
+#define GETOPT_ERROR_UNKNOWN		1 /* Not a valid option.  */
+#define GETOPT_ERROR_AMBIGUOUS		2 /* Abbreviates several options.  */
+#define GETOPT_ERROR_MISSING_ARG	3 /* Required argument not given.  */
+#define GETOPT_ERROR_UNEXPECTED_ARG	4 /* Argument given to an option
+					     that takes none.  */
+
+/* The most names `struct getopt_error' suggests.  */
+#define GETOPT_MAX_SUGGESTIONS	3
+
+/* Bits of `struct getopt_error.flags'.  */
+#define GETOPT_ERROR_POSIX	0x1	/* POSIXLY_CORRECT was set.  */
+#define GETOPT_ERROR_W		0x2	/* The option was given with `-W'.  */
+
+/* One error, as passed to the `error' function of a scan.  The views
+   point into the ARGV-elements themselves.  */
+struct getopt_error
+{
+  int code;			/* One of the GETOPT_ERROR_* codes.  */
+  int flags;
+  int argind;			/* Index in ARGV of the element, before any
+				   permutation at the end of the scan.  */
+  struct getopt_view progname;	/* ARGV[0].  */
+
+  /* The option as given: the option character for a short option, or
+     for a long one the whole ARGV-element (just the name after `-W').  */
+  struct getopt_view option;
+  /* For a long option, the rest of the element from where its name was
+     looked up.  */
+  struct getopt_view name;
+  int optchar;			/* The short option character, or 0.  */
+  const struct option *longopt;	/* For GETOPT_ERROR_UNEXPECTED_ARG and
+				   GETOPT_ERROR_MISSING_ARG of a long
+				   option, the one that was matched.  */
+
+  /* For GETOPT_ERROR_UNKNOWN and GETOPT_ERROR_AMBIGUOUS of a long option
+     in a scan with a `nameindex': the nearest long names, nearest first,
+     or the first of those the abbreviation matches, in the order of
+     LONGOPTS, or sorted by name in a scan with a `longindex'.  */
+  const char *suggestions[GETOPT_MAX_SUGGESTIONS];
+  int nsuggestions;
+};
+
+struct getopt_state
+{
+  int optind;
+  int opterr;
+  int optopt;
+  char *optarg;
+  /* The length of `optarg', set only by the `*_view_r' entry points.  */
+  size_t optarglen;
+
+  /* If not null, long options are looked up in this index instead of by
+     scanning LONGOPTS.  It must have been built from the same LONGOPTS
+     that are passed to the scan; see `getopt_longindex_new'.  */
+  const struct getopt_longindex *longindex;
+
+  /* If not null, errors about unknown or ambiguous long options suggest
+     names, and the messages printed end in a `did you mean' line.  It
+     must have been built from the names of the LONGOPTS that are passed
+     to the scan; see `getopt_nameindex_new'.  */
+  const struct getopt_nameindex *nameindex;
+
+  /* If not null, ARGV is never written to.  The indices of the
+     non-option elements are appended here instead, in the order a
+     permuting scan would have moved them to, and `noperands' counts them.
+     There must be room for ARGC elements.  Once the scan has returned -1,
+     `optind' is ARGC and `operands' lists every operand, including those
+     after `--' or, in REQUIRE_ORDER, after the first non-option.  */
+  int *operands;
+  int noperands;
+
+  /* If not null, every error is described to this function, with
+     `error_cookie' as its first argument, instead of being printed on
+     stderr; that happens whatever `opterr' says.  No message is formatted
+     unless the function calls `getopt_error_format'.  */
+  void (*error) (void *, const struct getopt_error *);
+  void *error_cookie;
+
+  int __initialized;
+  char *__nextchar;
+  char *__end;
+  int __ordering;
+  int __posixly_correct;
+  int __first_nonopt;
+  int __last_nonopt;
+  int __argind;
+  int *__runs;
+  int __nruns;
+  int __maxruns;
+  int __npending;
+  int __argbase;
+  int __inlineruns[2 * _GETOPT_INLINE_RUNS];
+};
+
+#define GETOPT_STATE_INITIALIZER \
+  { 1, 1, '?', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, \
+    { 0 } }
+
 #ifndef __need_getopt
 /* Describe the long-named options requested by the application.
    The LONG_OPTIONS argument to getopt_long or getopt_long_only is a vector
@@ -144,7 +281,12 @@ struct option
 
    If OPTS begins with `--', then non-option arguments are treated as
    arguments to the option '\0'.  This behavior is specific to the GNU
-   `getopt'.  */
+   `getopt'.
+
+   If OPTS begins with `:', or with `:' after a leading `-' or `+', no
+   messages are printed and `:' rather than '?' is returned for an option
+   missing its argument.  The `_spec_r' and `_view_r' functions follow the
+   same rule.  */
 
 #if (defined __STDC__ && __STDC__) || defined __cplusplus || defined WIN32
 # if defined __GNU_LIBRARY__ || defined WIN32
@@ -155,6 +297,16 @@ extern EXPORTS_API int getopt (int __argc, char *const *__argv, const char *__sh
 # else /* not __GNU_LIBRARY__ */
 extern EXPORTS_API int getopt ();
 # endif /* __GNU_LIBRARY__ */
+extern EXPORTS_API int getopt_r (int __argc, char *const *__argv,
+				 const char *__shortopts,
+				 struct getopt_state *__state);
+extern EXPORTS_API void getopt_state_release (struct getopt_state *__state);
+
+/* Write the message that describes ERR, as getopt prints it by default,
+   into the SIZE bytes at BUF, like `snprintf'.  Returns the length of the
+   whole message, which was truncated if that is SIZE or more.  */
+extern EXPORTS_API int getopt_error_format (const struct getopt_error *__err,
+					    char *__buf, size_t __size);
 
 # ifndef __need_getopt
 extern EXPORTS_API int getopt_long (int __argc, char *const *__argv, const char *__shortopts,
@@ -163,6 +315,338 @@ extern EXPORTS_API int getopt_long_only (int __argc, char *const *__argv,
 			     const char *__shortopts,
 		             const struct option *__longopts, int *__longind);
 
+extern EXPORTS_API int getopt_long_r (int __argc, char *const *__argv,
+				      const char *__shortopts,
+				      const struct option *__longopts,
+				      int *__longind,
+				      struct getopt_state *__state);
+extern EXPORTS_API int getopt_long_only_r (int __argc, char *const *__argv,
+					   const char *__shortopts,
+					   const struct option *__longopts,
+					   int *__longind,
+					   struct getopt_state *__state);
+
+/* Build a lookup index over LONGOPTS for `struct getopt_state.longindex'.
+   It resolves exact names and unique abbreviations in time proportional to
+   the length of the name rather than to the number of options.  The index
+   refers to LONGOPTS by position, is never modified after it is built and
+   may be shared by any number of concurrent scans.  Returns null if memory
+   is exhausted.  */
+extern EXPORTS_API struct getopt_longindex *
+getopt_longindex_new (const struct option *__longopts);
+extern EXPORTS_API void getopt_longindex_free (struct getopt_longindex *__index);
+
+/* Build an index for finding the names nearest to a misspelled one, by
+   edit distance.  The names are NNAMES `const char *' that are STRIDE
+   bytes apart starting at NAMES, or if NNAMES is negative, those up to
+   the first null one.  STRIDE zero means an array of pointers; use
+   `sizeof (struct option)' for the names of a LONGOPTS and pass
+   `&longopts[0].name'.  The names must outlive the index, which is never
+   modified after it is built and may be shared by concurrent lookups.
+   Returns null if memory is exhausted.  */
+extern EXPORTS_API struct getopt_nameindex *
+getopt_nameindex_new (const char *const *__names, int __nnames,
+		      size_t __stride);
+extern EXPORTS_API void getopt_nameindex_free (struct getopt_nameindex *__index);
+
+/* Store in NEAREST the indices of up to MAXNEAREST names at most MAXDIST
+   edits away from the NAMELEN characters at NAME, nearest first and
+   otherwise in the order of the names.  Returns how many were stored.  A
+   name that occurs several times is only found at its first index.  */
+extern EXPORTS_API int getopt_nameindex_nearest (const struct getopt_nameindex *__index,
+						 const char *__name,
+						 size_t __namelen,
+						 int __maxdist, int *__nearest,
+						 int __maxnearest);
+
+/* Compile OPTSTRING and LONGOPTS (which may be null) into an immutable
+   specification: the option characters and whether they take arguments,
+   the ordering requested by a leading `-' or `+' (or by POSIXLY_CORRECT,
+   which is looked up here, once) and an index over LONGOPTS.  Both
+   arguments must outlive the result, which may be shared by any number of
+   concurrent scans.  Returns null if memory is exhausted.
+
+   `getopt_long_spec_r' and `getopt_long_only_spec_r' then behave like
+   `getopt_long_r' and `getopt_long_only_r' with those arguments, without
+   analyzing them again on every call.  */
+extern EXPORTS_API struct getopt_spec *
+getopt_compile (const char *__shortopts, const struct option *__longopts);
+extern EXPORTS_API void getopt_spec_free (struct getopt_spec *__spec);
+
+extern EXPORTS_API int getopt_long_spec_r (int __argc, char *const *__argv,
+					   const struct getopt_spec *__spec,
+					   int *__longind,
+					   struct getopt_state *__state);
+extern EXPORTS_API int getopt_long_only_spec_r (int __argc,
+						char *const *__argv,
+						const struct getopt_spec *__spec,
+						int *__longind,
+						struct getopt_state *__state);
+
+/* One result of `getopt_parse_all': what a call of `getopt_long_spec_r'
+   would have returned, the index in LONGOPTS of the long option found (or
+   -1), the value of `optarg', and the index in ARGV of the element the
+   option was found in, as ARGV is left at the end of the scan.  */
+struct getopt_event
+{
+  int opt;
+  int longind;
+  char *optarg;
+  int argind;
+};
+
+/* Flags for `getopt_parse_all'.  */
+# define GETOPT_PARSE_LONG_ONLY	0x1	/* Scan like `getopt_long_only'.  */
+# define GETOPT_PARSE_QUIET	0x2	/* As if `opterr' were zero.  */
+
+/* Scan all of ARGV for the options compiled into SPEC in one call and
+   store the options found, in order, in EVENTS.  Returns the number of
+   options found; if that is more than MAXEVENTS, only the first MAXEVENTS
+   were stored.  ARGV is permuted as by the iterative interface, and the
+   operands are the elements from *OPERIND up to ARGC.  */
+extern EXPORTS_API int getopt_parse_all (int __argc, char *const *__argv,
+					 const struct getopt_spec *__spec,
+					 int __flags,
+					 struct getopt_event *__events,
+					 int __maxevents, int *__operind);
+
+/* The same without writing to ARGV, which may then be shared read-only
+   by concurrent scans.  The indices of the operands are stored in
+   OPERANDS, which must have room for ARGC elements, and their number in
+   *NOPERANDS; `argind' of the events indexes ARGV as it was given.  */
+extern EXPORTS_API int getopt_parse_all_operands (int __argc,
+						  char *const *__argv,
+						  const struct getopt_spec *__spec,
+						  int __flags,
+						  struct getopt_event *__events,
+						  int __maxevents,
+						  int *__operands,
+						  int *__noperands);
+
+/* One command line for `getopt_parse_bulk' and the results of its scan:
+   as from `getopt_parse_all_operands', with the errors found described in
+   ERRORS.  NEVENTS and NERRORS count all of them, even those that there
+   was no room to store.  */
+struct getopt_job
+{
+  int argc;
+  char *const *argv;
+
+  struct getopt_event *events;
+  int maxevents;
+  int nevents;
+
+  int *operands;		/* Room for ARGC elements.  */
+  int noperands;
+
+  struct getopt_error *errors;
+  int maxerrors;
+  int nerrors;
+};
+
+/* Scan each of the NJOBS command lines in JOBS for the options compiled
+   into SPEC, with FLAGS as for `getopt_parse_all', on up to NTHREADS
+   threads (one per processor if NTHREADS is zero or less).  No argument
+   vector is written to and nothing is printed.  Returns the number of
+   jobs with errors.  */
+extern EXPORTS_API int getopt_parse_bulk (struct getopt_job *__jobs,
+					  int __njobs,
+					  const struct getopt_spec *__spec,
+					  int __flags, int __nthreads);
+
+/* Scan ARGC such elements for the options compiled into SPEC, like
+   `getopt_long_spec_r' and `getopt_long_only_spec_r' do for strings.
+   `optarg' then points into the element it was found in, and `optarglen'
+   gives its length.  VIEWS is never reordered: the operands are found
+   through `operands' in STATE (see above) if that is set, and are passed
+   over otherwise.  */
+extern EXPORTS_API int getopt_long_view_r (int __argc,
+					   const struct getopt_view *__views,
+					   const struct getopt_spec *__spec,
+					   int *__longind,
+					   struct getopt_state *__state);
+extern EXPORTS_API int getopt_long_only_view_r (int __argc,
+						const struct getopt_view *__views,
+						const struct getopt_spec *__spec,
+						int *__longind,
+						struct getopt_state *__state);
+
+/* A scan over elements that are produced one at a time by SOURCE, which
+   stores the next one in *ELT and returns nonzero, or returns zero when
+   there are no more.  The first element is the program name.  Only that
+   and three more elements are held at any time, as many as `-W NAME ARG'
+   spans, so the bytes of each must stay valid until the scan has moved
+   past it and its `optarg' has been used.
+
+   Operands cannot be held back until the end without unbounded memory,
+   so each one is returned as soon as it is read, as in RETURN_IN_ORDER:
+   the result is 1 and `optarg' is the operand.  After `--', and in
+   REQUIRE_ORDER from the first non-option on, every remaining element is
+   returned that way.  -1 means the source is exhausted.  `state.optind'
+   counts the elements consumed, the program name included; `opterr' may
+   be set in `state' before the first call.  */
+struct getopt_stream
+{
+  struct getopt_state state;
+
+  int (*__source) (void *, struct getopt_view *);
+  void *__cookie;
+  struct getopt_view __window[4];
+  int __nwindow;
+  int __started;
+  int __eof;
+  int __nomoreopts;
+};
+
+extern EXPORTS_API void getopt_stream_init (struct getopt_stream *__stream,
+					    int (*__source) (void *__cookie,
+							     struct getopt_view *__elt),
+					    void *__cookie);
+extern EXPORTS_API int getopt_long_stream_r (struct getopt_stream *__stream,
+					     const struct getopt_spec *__spec,
+					     int *__longind);
+extern EXPORTS_API int getopt_long_only_stream_r (struct getopt_stream *__stream,
+						  const struct getopt_spec *__spec,
+						  int *__longind);
+
+/* A source for `getopt_stream_init' that yields the ARGC elements of ARGV
+   with every `@FILE' after the program name replaced by the arguments in
+   FILE, as GCC does: separated by white space, quoted with `'' or `"' or
+   escaped with a backslash, and possibly naming further files with
+   `@FILE'.  A FILE that cannot be opened is passed on as it is.  Each file
+   is mapped into memory and its arguments are views into it, valid until
+   `getopt_respfile_free'; ARGV must stay valid as long.  Returns null if
+   memory is exhausted.
+
+   Pass `getopt_respfile_next' as the source and the result as its cookie.
+   If a file that was opened cannot be read, or files are nested too
+   deeply, the source ends early; `getopt_respfile_error' then returns the
+   error number, and stores the name of the file in *FILE unless that is
+   null.  It returns zero otherwise.  */
+extern EXPORTS_API struct getopt_respfile *
+getopt_respfile_new (int __argc, char *const *__argv);
+extern EXPORTS_API void getopt_respfile_free (struct getopt_respfile *__r);
+extern EXPORTS_API int getopt_respfile_next (void *__r,
+					     struct getopt_view *__elt);
+extern EXPORTS_API int getopt_respfile_error (const struct getopt_respfile *__r,
+					      struct getopt_view *__file);
+
+/* Memory given to `getopt_split': SIZE bytes at BASE, of which the first
+   USED are taken.  Set USED back to zero to reuse all of it.  */
+struct getopt_arena
+{
+  char *base;
+  size_t size;
+  size_t used;
+};
+
+/* Errors of `getopt_split'.  */
+#define GETOPT_SPLIT_UNTERMINATED	-1 /* A quote was never closed.  */
+#define GETOPT_SPLIT_NOSPACE		-2 /* The arena is too small.  */
+
+/* The arena room that always suffices for a line of LEN bytes: a pointer
+   for each word, which with its delimiter takes two bytes at least, and
+   for the program name and the final null, plus alignment.  */
+#define GETOPT_SPLIT_ARENA_SIZE(len) \
+  (((len) / 2 + 4) * sizeof (char *))
+
+/* Split LINE into words at blanks and newlines, with the quoting of the
+   POSIX shell: `\' quotes the next character, `'...'' quotes everything
+   up to the closing quote, and `"..."' everything but a `\' before
+   `"', `\', `$', `\`' or a newline.  A backslash before a newline
+   continues the line.  Nothing is expanded or taken as a comment.
+
+   The words are written over LINE, each ending with a NUL, and the
+   vector of them, ending with a null pointer, is taken from ARENA.  It
+   starts with PROGNAME unless that is null, so that it can be passed to
+   `getopt_long_r' and the like as it is.  Returns the number of elements
+   and stores the vector in *ARGV, or returns one of the errors above with
+   nothing taken from ARENA, but LINE partly rewritten.  */
+extern EXPORTS_API int getopt_split (char *__line, char *__progname,
+				     struct getopt_arena *__arena,
+				     char ***__argv);
+
+/* Recording.  While it is on, every scan appends the command line it
+   starts on to a log file of CAPACITY bytes at PATH, for `getopt_replay'
+   to run again: the options given to the scan once, then its ARGV, the
+   `optind' it started at and how it was to be scanned.  Streams are not
+   recorded.  Appending takes no lock; records that no longer fit are
+   counted and dropped.  `getopt_record_start' returns zero or an error
+   number, EBUSY if a recording is on already.  `getopt_record_stop' may
+   run concurrently with scans: it turns the recording off, waits for the
+   records being written to be finished, writes the log out, stores the
+   number of records dropped in *DROPPED unless that is null, and returns
+   zero, or EINVAL if no recording was on.  */
+extern EXPORTS_API int getopt_record_start (const char *__path,
+					    size_t __capacity);
+extern EXPORTS_API int getopt_record_stop (unsigned long long *__dropped);
+extern EXPORTS_API int getopt_recording (void);
+
+/* The log starts with these 8 bytes.  */
+#define GETOPT_RECORD_MAGIC	"GOPTRC1"
+
+/* Types of records.  */
+#define GETOPT_RECORD_OPTIONS		1 /* A LONGOPTS.  */
+#define GETOPT_RECORD_SCAN		2 /* The start of a getopt scan.  */
+#define GETOPT_RECORD_PARAMS		3 /* A moduleparam table.  */
+#define GETOPT_RECORD_PARSE_ARGS	4 /* A call of `parse_args'.  */
+
+/* Flags of a GETOPT_RECORD_SCAN.  */
+#define GETOPT_RECORD_LONG_ONLY		0x1
+#define GETOPT_RECORD_REQUIRE_ORDER	0x2
+#define GETOPT_RECORD_RETURN_IN_ORDER	0x4
+#define GETOPT_RECORD_VIEWS		0x8
+
+/* Other parsers add their own records to the log: reserve LEN bytes for
+   the payload of a record of TYPE, fill them in, then mark the record
+   complete.  Returns null if no recording is on or there is no room;
+   otherwise `getopt_record_end' must follow, as `getopt_record_stop'
+   waits for it.  `getopt_record_once' returns nonzero the first time it
+   sees the table at KEY with contents that hash to HASH during a
+   recording, so that a table is written once for all the records that
+   refer to it, and again if its memory is reused for another.
+   `getopt_record_hash' folds LEN bytes at P into such a hash, which
+   starts at zero.  */
+extern EXPORTS_API void *getopt_record_begin (int __type, size_t __len);
+extern EXPORTS_API void getopt_record_end (void *__payload);
+extern EXPORTS_API int getopt_record_once (const void *__key,
+					   unsigned long long __hash);
+extern EXPORTS_API unsigned long long
+getopt_record_hash (unsigned long long __h, const void *__p, size_t __len);
+
+/* One subcommand of a program in the style of `git': the verb NAME and
+   the options it accepts after it.  DATA is for the caller, for instance
+   the function that carries the subcommand out.  An array of these ends
+   with an element whose NAME is null.  */
+struct getopt_command
+{
+  const char *name;
+  const char *optstring;
+  const struct option *longopts;
+  void *data;
+};
+
+/* Index COMMANDS by name for `getopt_commands_find'.  Nothing is compiled
+   yet; the options of a subcommand are compiled by the first call of
+   `getopt_commands_spec' for it, so the cost of a run is that of the
+   subcommand it uses, not of all of them.  COMMANDS must outlive the
+   result.  Returns null if memory is exhausted.  */
+extern EXPORTS_API struct getopt_commands *
+getopt_commands_new (const struct getopt_command *__commands);
+extern EXPORTS_API void getopt_commands_free (struct getopt_commands *__cmds);
+
+/* The index in COMMANDS of the subcommand called exactly NAME, or -1.  */
+extern EXPORTS_API int getopt_commands_find (const struct getopt_commands *__cmds,
+					     const char *__name);
+
+/* The compiled options of subcommand INDEX, for `getopt_long_spec_r' and
+   the like over the elements from the verb on, the verb taking the place
+   of the program name.  Returns null if memory is exhausted.  Different
+   subcommands may be looked up concurrently, but the first lookup of one
+   must not race with another lookup of the same one.  */
+extern EXPORTS_API const struct getopt_spec *
+getopt_commands_spec (struct getopt_commands *__cmds, int __index);
+
 /* Internal only.  Users should not call this directly.  */
 extern EXPORTS_API int _getopt_internal (int __argc, char *const *__argv,
 			     const char *__shortopts,
@@ -171,9 +655,47 @@ extern EXPORTS_API int _getopt_internal (int __argc, char *const *__argv,
 # endif
 #else /* not __STDC__ */
 extern EXPORTS_API int getopt ();
+extern EXPORTS_API int getopt_r ();
+extern EXPORTS_API void getopt_state_release ();
+extern EXPORTS_API int getopt_error_format ();
 # ifndef __need_getopt
 extern EXPORTS_API int getopt_long ();
 extern EXPORTS_API int getopt_long_only ();
+extern EXPORTS_API int getopt_long_r ();
+extern EXPORTS_API int getopt_long_only_r ();
+extern EXPORTS_API struct getopt_longindex *getopt_longindex_new ();
+extern EXPORTS_API void getopt_longindex_free ();
+extern EXPORTS_API struct getopt_nameindex *getopt_nameindex_new ();
+extern EXPORTS_API void getopt_nameindex_free ();
+extern EXPORTS_API int getopt_nameindex_nearest ();
+extern EXPORTS_API struct getopt_spec *getopt_compile ();
+extern EXPORTS_API void getopt_spec_free ();
+extern EXPORTS_API int getopt_long_spec_r ();
+extern EXPORTS_API int getopt_long_only_spec_r ();
+extern EXPORTS_API int getopt_parse_all ();
+extern EXPORTS_API int getopt_parse_all_operands ();
+extern EXPORTS_API int getopt_parse_bulk ();
+extern EXPORTS_API int getopt_long_view_r ();
+extern EXPORTS_API int getopt_long_only_view_r ();
+extern EXPORTS_API void getopt_stream_init ();
+extern EXPORTS_API int getopt_long_stream_r ();
+extern EXPORTS_API int getopt_long_only_stream_r ();
+extern EXPORTS_API struct getopt_respfile *getopt_respfile_new ();
+extern EXPORTS_API void getopt_respfile_free ();
+extern EXPORTS_API int getopt_respfile_next ();
+extern EXPORTS_API int getopt_respfile_error ();
+extern EXPORTS_API int getopt_split ();
+extern EXPORTS_API int getopt_record_start ();
+extern EXPORTS_API int getopt_record_stop ();
+extern EXPORTS_API int getopt_recording ();
+extern EXPORTS_API void *getopt_record_begin ();
+extern EXPORTS_API void getopt_record_end ();
+extern EXPORTS_API int getopt_record_once ();
+extern EXPORTS_API unsigned long long getopt_record_hash ();
+extern EXPORTS_API struct getopt_commands *getopt_commands_new ();
+extern EXPORTS_API void getopt_commands_free ();
+extern EXPORTS_API int getopt_commands_find ();
+extern EXPORTS_API const struct getopt_spec *getopt_commands_spec ();
 
 extern EXPORTS_API int _getopt_internal ();
 # endif
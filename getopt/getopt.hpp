@@ -0,0 +1,953 @@
+/* Compile-time option tables for C++.
+   This file is distributed under the same terms as getopt.c.
+
+   With the C interface, an option is described three times: in the
+   `struct option' array, in the OPTSTRING and in the `switch' on what
+   `getopt_long' returned, and nothing checks that the three agree.  Here
+   an option is declared once, together with the member of a configuration
+   structure that receives it:
+
+     struct config { bool all; int verbose; long count; const char *out; };
+
+     GETOPT_TABLE (options,
+		   getopt_cxx::flag ('a', "all", &config::all),
+		   getopt_cxx::count ('v', "verbose", &config::verbose),
+		   getopt_cxx::value ('n', "count", &config::count),
+		   getopt_cxx::value ('o', nullptr, &config::out));
+
+     config cfg = config ();
+     getopt_cxx::result r = getopt_cxx::parse (options, argc, argv, cfg,
+					       operands);
+
+   The table is a constant expression.  It holds the option characters as
+   a 256-entry map and the long names as a perfect hash whose seed is
+   searched for by the compiler, so there is nothing to set up at run time
+   and a long option is recognized with one hash and one comparison.  An
+   abbreviation is looked up by a binary search of the long names, which
+   the compiler sorts, and the options that do the same thing are worked
+   out by the compiler too.  The action for an option is chosen by a chain
+   of comparisons on its index that the compiler unrolls into the scan,
+   the same as a hand-written `switch'.  GETOPT_TABLE rejects duplicate
+   option characters, duplicate long names, characters that cannot be
+   options and long names no seed hashes apart with `static_assert'.
+
+   The scan follows the GNU rules, except that ARGV is left alone: the
+   indices of the operands are stored in OPERANDS, in order, as by
+   `getopt_parse_all_operands'.  The ordering is a template argument of
+   `parse': by default PERMUTE, or REQUIRE_ORDER if POSIXLY_CORRECT is set,
+   as for an OPTSTRING that starts with neither `+' nor `-'.  Long names
+   may be abbreviated to any prefix that matches exactly one of them, or
+   only options that do the same thing: the same kind of option with the
+   same destination, like those with the same `has_arg', `flag' and `val'
+   in a `struct option'.  The scan stops at the first error and reports it
+   in the result; nothing is printed.
+
+   Everything is C++11, so the constant expressions below are written as
+   single-return functions.  */
+
+#ifndef _GETOPT_HPP
+#define _GETOPT_HPP 1
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#include "getopt.h"
+
+namespace getopt_cxx
+{
+
+/* Why a scan stopped.  The first four are the codes of `struct
+   getopt_error'.  */
+enum class errc
+{
+  none = 0,
+  unknown = GETOPT_ERROR_UNKNOWN,
+  ambiguous = GETOPT_ERROR_AMBIGUOUS,
+  missing_arg = GETOPT_ERROR_MISSING_ARG,
+  unexpected_arg = GETOPT_ERROR_UNEXPECTED_ARG,
+  /* The argument could not be converted to the destination's type.  */
+  bad_value = 16
+};
+
+struct result
+{
+  errc error;
+  /* The element in which the error is, or ARGC.  */
+  int argind;
+  /* The offending option as written, without its argument.  */
+  const char *option;
+  std::size_t optlen;
+  /* Number of operand indices stored.  */
+  int noperands;
+
+  explicit operator bool () const { return error == errc::none; }
+};
+
+inline const char *
+describe (errc e)
+{
+  switch (e)
+    {
+    case errc::none:
+      return "no error";
+    case errc::unknown:
+      return "unrecognized option";
+    case errc::ambiguous:
+      return "ambiguous option";
+    case errc::missing_arg:
+      return "option requires an argument";
+    case errc::unexpected_arg:
+      return "option doesn't allow an argument";
+    case errc::bad_value:
+      return "invalid argument";
+    }
+  return "unknown error";
+}
+
+/* Converting an argument to a destination.  These return false if ARG is
+   not a valid value; other types can be supported by overloads found by
+   argument-dependent lookup.  */
+
+inline bool
+parse_value (const char *arg, const char *&out)
+{
+  out = arg;
+  return true;
+}
+
+inline bool
+parse_value (const char *arg, std::string &out)
+{
+  out = arg;
+  return true;
+}
+
+/* The spellings `param_set_bool' accepts in moduleparam.  */
+inline bool
+parse_value (const char *arg, bool &out)
+{
+  if ((arg[0] == 'y' || arg[0] == 'Y' || arg[0] == '1') && arg[1] == '\0')
+    out = true;
+  else if ((arg[0] == 'n' || arg[0] == 'N' || arg[0] == '0') && arg[1] == '\0')
+    out = false;
+  else
+    return false;
+  return true;
+}
+
+template <class T>
+typename std::enable_if<std::is_integral<T>::value
+			&& std::is_signed<T>::value, bool>::type
+parse_value (const char *arg, T &out)
+{
+  char *end;
+  long long v;
+
+  errno = 0;
+  v = std::strtoll (arg, &end, 0);
+  if (end == arg || *end != '\0' || errno == ERANGE
+      || v < (long long) std::numeric_limits<T>::min ()
+      || v > (long long) std::numeric_limits<T>::max ())
+    return false;
+  out = (T) v;
+  return true;
+}
+
+template <class T>
+typename std::enable_if<std::is_integral<T>::value
+			&& std::is_unsigned<T>::value
+			&& !std::is_same<T, bool>::value, bool>::type
+parse_value (const char *arg, T &out)
+{
+  char *end;
+  unsigned long long v;
+
+  errno = 0;
+  v = std::strtoull (arg, &end, 0);
+  if (end == arg || *end != '\0' || errno == ERANGE || arg[0] == '-'
+      || v > (unsigned long long) std::numeric_limits<T>::max ())
+    return false;
+  out = (T) v;
+  return true;
+}
+
+template <class T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+parse_value (const char *arg, T &out)
+{
+  char *end;
+  long double v;
+
+  errno = 0;
+  v = std::strtold (arg, &end);
+  if (end == arg || *end != '\0' || errno == ERANGE)
+    return false;
+  out = (T) v;
+  return true;
+}
+
+/* How options and operands may be mixed, as chosen by the first character
+   of an OPTSTRING.  */
+enum class ordering
+{
+  /* PERMUTE, or REQUIRE_ORDER if POSIXLY_CORRECT is set.  */
+  environment,
+  /* Options anywhere; the operands are collected in OPERANDS.  */
+  permute,
+  /* `+': options until the first operand.  */
+  require_order,
+  /* `-': each operand in turn among the options.  Not supported, since
+     operands are only collected in OPERANDS.  */
+  return_in_order
+};
+
+/* Option declarations.  */
+
+enum kind { kind_flag, kind_count, kind_value };
+
+template <class C, class T, int K>
+struct opt
+{
+  typedef C config_type;
+
+  char short_name;
+  const char *long_name;
+  T C::*member;
+
+  static constexpr int has_arg ()
+  {
+    return K == kind_value ? required_argument : no_argument;
+  }
+
+  bool apply (C &cfg, const char *arg) const
+  {
+    return apply (cfg, arg, std::integral_constant<int, K> ());
+  }
+
+private:
+  bool apply (C &cfg, const char *,
+	      std::integral_constant<int, kind_flag>) const
+  {
+    cfg.*member = true;
+    return true;
+  }
+
+  bool apply (C &cfg, const char *,
+	      std::integral_constant<int, kind_count>) const
+  {
+    ++(cfg.*member);
+    return true;
+  }
+
+  bool apply (C &cfg, const char *arg,
+	      std::integral_constant<int, kind_value>) const
+  {
+    return arg != nullptr && parse_value (arg, cfg.*member);
+  }
+};
+
+/* An optional argument.  When it is absent the destination is set to
+   IMPLICIT, which makes T a literal type such as `const char *' or
+   `int'.  */
+template <class C, class T>
+struct opt_optional
+{
+  typedef C config_type;
+
+  char short_name;
+  const char *long_name;
+  T C::*member;
+  T implicit;
+
+  static constexpr int has_arg () { return optional_argument; }
+
+  bool apply (C &cfg, const char *arg) const
+  {
+    if (arg == nullptr)
+      {
+	cfg.*member = implicit;
+	return true;
+      }
+    return parse_value (arg, cfg.*member);
+  }
+};
+
+/* A short name of 0 or a long name of nullptr means the option has none.  */
+
+/* Sets a bool to true.  */
+template <class C>
+constexpr opt<C, bool, kind_flag>
+flag (char short_name, const char *long_name, bool C::*member)
+{
+  return opt<C, bool, kind_flag> { short_name, long_name, member };
+}
+
+/* Increments a number every time the option occurs.  */
+template <class C, class T>
+constexpr opt<C, T, kind_count>
+count (char short_name, const char *long_name, T C::*member)
+{
+  return opt<C, T, kind_count> { short_name, long_name, member };
+}
+
+/* Stores the option's required argument.  */
+template <class C, class T>
+constexpr opt<C, T, kind_value>
+value (char short_name, const char *long_name, T C::*member)
+{
+  return opt<C, T, kind_value> { short_name, long_name, member };
+}
+
+template <class C, class T>
+constexpr opt_optional<C, T>
+optional_value (char short_name, const char *long_name, T C::*member,
+		T implicit)
+{
+  return opt_optional<C, T> { short_name, long_name, member, implicit };
+}
+
+namespace detail
+{
+
+template <std::size_t... I> struct indices {};
+
+template <class A, class B> struct concat;
+
+template <std::size_t... I, std::size_t... J>
+struct concat<indices<I...>, indices<J...> >
+{
+  typedef indices<I..., (sizeof... (I) + J)...> type;
+};
+
+/* 0 ... N-1, in logarithmic template depth so that large hash tables do
+   not run into the instantiation limit.  */
+template <std::size_t N>
+struct make_indices
+  : concat<typename make_indices<N / 2>::type,
+	   typename make_indices<N - N / 2>::type>
+{
+};
+
+template <> struct make_indices<0> { typedef indices<> type; };
+template <> struct make_indices<1> { typedef indices<0> type; };
+
+constexpr std::size_t
+length (const char *s)
+{
+  return s == nullptr || *s == '\0' ? 0 : 1 + length (s + 1);
+}
+
+constexpr bool
+equal (const char *a, const char *b)
+{
+  return *a == *b && (*a == '\0' || equal (a + 1, b + 1));
+}
+
+constexpr bool
+contains (const char *s, char c)
+{
+  return *s != '\0' && (*s == c || contains (s + 1, c));
+}
+
+/* Negative, zero or positive as A sorts before, with or after B.  */
+constexpr int
+compare (const char *a, const char *b)
+{
+  return *a != *b ? ((unsigned char) *a < (unsigned char) *b ? -1 : 1)
+    : *a == '\0' ? 0 : compare (a + 1, b + 1);
+}
+
+/* FNV-1a, started from a state that depends on SEED.  Tail-recursive, so
+   at run time it compiles to the usual loop.  */
+constexpr unsigned long
+fnv (const char *s, std::size_t n, unsigned long h)
+{
+  return n == 0 ? h
+    : fnv (s + 1, n - 1,
+	   ((h ^ (unsigned char) *s) * 16777619ul) & 0xfffffffful);
+}
+
+constexpr std::size_t
+bucket (const char *s, std::size_t n, unsigned long seed, std::size_t mask)
+{
+  return (std::size_t) (fnv (s, n, (2166136261ul ^ (seed * 2654435761ul))
+			     & 0xfffffffful) >> 7) & mask;
+}
+
+constexpr std::size_t
+next_pow2 (std::size_t n, std::size_t p = 1)
+{
+  return p >= n ? p : next_pow2 (n, p * 2);
+}
+
+/* Enough buckets that a random seed is collision-free with probability
+   about 1/8 or better, so the search below ends after a few tries.  */
+constexpr std::size_t
+hash_size (std::size_t n)
+{
+  return next_pow2 (n * n / 4 > 2 * n ? n * n / 4 : 2 * n);
+}
+
+/* Seeds tried before giving up on a perfect hash, which GETOPT_TABLE
+   rejects.  */
+constexpr unsigned long max_seed = 128;
+
+constexpr std::size_t no_bucket = (std::size_t) -1;
+
+/* The buckets of the long names of a table for one seed, NO_BUCKET for
+   the options without one.  Computed once per seed, so that checking the
+   seed and filling the table compare numbers rather than hash strings.
+   The recursion goes over I and, separately, over J, so that its depth
+   stays linear in N.  */
+template <std::size_t N>
+struct bucket_list
+{
+  std::size_t of[N];
+
+  constexpr bool
+  differs (std::size_t i, std::size_t j) const
+  {
+    return j >= N ? true
+      : (of[i] == no_bucket || of[i] != of[j]) && differs (i, j + 1);
+  }
+
+  constexpr bool
+  distinct (std::size_t i = 0) const
+  {
+    return i >= N ? true : differs (i, i + 1) && distinct (i + 1);
+  }
+
+  constexpr int
+  slot (std::size_t b, std::size_t i = 0) const
+  {
+    return i >= N ? -1 : of[i] == b ? (int) i : slot (b, i + 1);
+  }
+};
+
+/* The place of each option in the order of the long names.  */
+template <std::size_t N>
+struct rank_list
+{
+  std::size_t of[N];
+
+  /* The option in place R.  */
+  constexpr int
+  at (std::size_t r, std::size_t i = 0) const
+  {
+    return i >= N ? -1 : of[i] == r ? (int) i : at (r, i + 1);
+  }
+};
+
+/* The names of a table, in a form the constant expressions can index.  */
+template <std::size_t N>
+struct name_list
+{
+  const char *long_names[N];
+  char short_names[N];
+
+  constexpr bool
+  short_differs (std::size_t i, std::size_t j) const
+  {
+    return j >= N ? true
+      : (short_names[i] == '\0' || short_names[i] != short_names[j])
+	&& short_differs (i, j + 1);
+  }
+
+  constexpr bool
+  short_unique (std::size_t i = 0) const
+  {
+    return i >= N ? true : short_differs (i, i + 1) && short_unique (i + 1);
+  }
+
+  constexpr bool
+  long_differs (std::size_t i, std::size_t j) const
+  {
+    return j >= N ? true
+      : (long_names[i] == nullptr || long_names[j] == nullptr
+	 || !equal (long_names[i], long_names[j]))
+	&& long_differs (i, j + 1);
+  }
+
+  constexpr bool
+  long_unique (std::size_t i = 0) const
+  {
+    return i >= N ? true : long_differs (i, i + 1) && long_unique (i + 1);
+  }
+
+  /* Every option has a name; option characters are not `:', `-' or `?',
+   which mean something else in the scan, and long names are not empty
+   and have no `=' in them.  */
+  constexpr bool
+  valid (std::size_t i = 0) const
+  {
+    return i >= N ? true
+      : (short_names[i] != '\0' || long_names[i] != nullptr)
+	&& !contains (":-?", short_names[i])
+	&& (long_names[i] == nullptr
+	    || (long_names[i][0] != '\0' && !contains (long_names[i], '=')))
+	&& valid (i + 1);
+  }
+
+  constexpr int
+  short_index (std::size_t c, std::size_t i = 0) const
+  {
+    return i >= N ? -1
+      : short_names[i] != '\0' && (unsigned char) short_names[i] == c
+	? (int) i : short_index (c, i + 1);
+  }
+
+  constexpr std::size_t
+  bucket_of (std::size_t i, unsigned long seed) const
+  {
+    return bucket (long_names[i], length (long_names[i]), seed,
+		   hash_size (N) - 1);
+  }
+
+  template <std::size_t... I>
+  constexpr bucket_list<N>
+  buckets (indices<I...>, unsigned long seed) const
+  {
+    return bucket_list<N> { { long_names[I] == nullptr ? no_bucket
+			      : bucket_of (I, seed)... } };
+  }
+
+  /* Whether option I comes before option J in the order of the long
+     names, the options without one last and in order.  */
+  constexpr bool
+  before (std::size_t i, std::size_t j) const
+  {
+    return long_names[j] == nullptr
+      ? long_names[i] != nullptr || i < j
+      : long_names[i] != nullptr && compare (long_names[i], long_names[j]) < 0;
+  }
+
+  constexpr std::size_t
+  rank (std::size_t i, std::size_t j = 0) const
+  {
+    return j >= N ? 0 : (before (j, i) ? 1 : 0) + rank (i, j + 1);
+  }
+
+  template <std::size_t... I>
+  constexpr rank_list<N>
+  ranks (indices<I...>) const
+  {
+    return rank_list<N> { { rank (I)... } };
+  }
+
+  constexpr std::size_t
+  count_long (std::size_t i = 0) const
+  {
+    return i >= N ? 0
+      : (long_names[i] != nullptr ? 1 : 0) + count_long (i + 1);
+  }
+
+  /* The first seed that hashes every long name to a bucket of its own, or
+   0 if there is none below MAX_SEED.  */
+  template <std::size_t... I>
+  constexpr unsigned long
+  find_seed (indices<I...> i, unsigned long seed = 1) const
+  {
+    return seed >= max_seed ? 0
+      : buckets (i, seed).distinct () ? seed : find_seed (i, seed + 1);
+  }
+};
+
+/* Whether two options do the same thing, so that an abbreviation of both
+   names is not ambiguous.  */
+
+template <class A, class B>
+constexpr bool
+same_option (const A &, const B &)
+{
+  return false;
+}
+
+template <class C, class T, int K>
+constexpr bool
+same_option (const opt<C, T, K> &a, const opt<C, T, K> &b)
+{
+  return a.member == b.member;
+}
+
+/* Only implicit values that are numbers can be compared in a constant
+   expression.  */
+template <class T>
+constexpr typename std::enable_if<std::is_arithmetic<T>::value, bool>::type
+same_value (T a, T b)
+{
+  return a == b;
+}
+
+template <class T>
+constexpr typename std::enable_if<!std::is_arithmetic<T>::value, bool>::type
+same_value (const T &, const T &)
+{
+  return false;
+}
+
+template <class C, class T>
+constexpr bool
+same_option (const opt_optional<C, T> &a, const opt_optional<C, T> &b)
+{
+  return a.member == b.member && same_value (a.implicit, b.implicit);
+}
+
+/* The options themselves, for the actions.  */
+
+template <class... O> struct storage;
+
+template <>
+struct storage<>
+{
+  constexpr storage () {}
+
+  template <class C>
+  bool apply (std::size_t, C &, const char *) const { return false; }
+
+  template <class X>
+  constexpr int find_same (const X &, int, int = 0) const { return -1; }
+};
+
+template <class H, class... T>
+struct storage<H, T...>
+{
+  H head;
+  storage<T...> tail;
+
+  constexpr storage (H h, T... t) : head (h), tail (t...) {}
+
+  template <class C>
+  bool apply (std::size_t k, C &cfg, const char *arg) const
+  {
+    return k == 0 ? head.apply (cfg, arg) : tail.apply (k - 1, cfg, arg);
+  }
+
+  /* The index of the first option that does the same as X, option I.  */
+  template <class X>
+  constexpr int
+  find_same (const X &x, int i, int k = 0) const
+  {
+    return k == i || same_option (head, x) ? k : tail.find_same (x, i, k + 1);
+  }
+};
+
+/* Option K of a storage.  */
+template <std::size_t K>
+struct element
+{
+  template <class S>
+  static constexpr auto
+  get (const S &s) -> decltype (element<K - 1>::get (s.tail))
+  {
+    return element<K - 1>::get (s.tail);
+  }
+};
+
+template <>
+struct element<0>
+{
+  template <class S>
+  static constexpr auto
+  get (const S &s) -> decltype ((s.head))
+  {
+    return s.head;
+  }
+};
+
+} /* namespace detail */
+
+template <class C, class... O>
+class table
+{
+  static_assert (sizeof... (O) > 0, "an option table needs options");
+  static_assert (sizeof... (O) < 128, "too many options for the maps");
+
+  enum : std::size_t
+  {
+    N = sizeof... (O),
+    HASH_SIZE = detail::hash_size (sizeof... (O))
+  };
+
+public:
+  typedef C config_type;
+
+  constexpr explicit table (O... o)
+    : table (typename detail::make_indices<256>::type (),
+	     typename detail::make_indices<HASH_SIZE>::type (),
+	     detail::name_list<N> { { o.long_name... }, { o.short_name... } },
+	     o...)
+  {
+  }
+
+  static constexpr std::size_t size () { return N; }
+
+  constexpr bool short_unique () const { return names_.short_unique (); }
+  constexpr bool long_unique () const { return names_.long_unique (); }
+  constexpr bool valid () const { return names_.valid (); }
+  constexpr bool perfect () const { return seed_ != 0; }
+
+  /* The index of the option with character C, or -1.  */
+  int
+  find_short (char c) const
+  {
+    return shorts_[(unsigned char) c];
+  }
+
+  /* The index of the long option NAME of LEN characters or of the first
+     long name it abbreviates, or -1.  AMBIGUOUS is set if it abbreviates
+     several that do not do the same thing.  */
+  int
+  find_long (const char *name, std::size_t len, bool &ambiguous) const
+  {
+    int k = slots_[detail::bucket (name, len, seed_, HASH_SIZE - 1)];
+    int found;
+    std::size_t lo = 0, hi = nlong_;
+
+    ambiguous = false;
+    if (k >= 0 && lens_[k] == len
+	&& !std::memcmp (names_.long_names[k], name, len))
+      return k;
+
+    /* The names it abbreviates are next to each other in order.  */
+    while (lo < hi)
+      {
+	std::size_t mid = lo + (hi - lo) / 2;
+	if (std::strncmp (names_.long_names[order_[mid]], name, len) < 0)
+	  lo = mid + 1;
+	else
+	  hi = mid;
+      }
+    if (lo == nlong_ || std::strncmp (names_.long_names[order_[lo]], name,
+				      len) != 0)
+      return -1;
+
+    found = order_[lo];
+    for (lo++; lo < nlong_
+	   && !std::strncmp (names_.long_names[order_[lo]], name, len); lo++)
+      {
+	if (same_[order_[lo]] != same_[found])
+	  ambiguous = true;
+	else if (order_[lo] < found)
+	  found = order_[lo];
+      }
+    return ambiguous ? -1 : found;
+  }
+
+  int has_arg (int k) const { return has_arg_[k]; }
+
+  bool
+  apply (int k, C &cfg, const char *arg) const
+  {
+    return options_.apply ((std::size_t) k, cfg, arg);
+  }
+
+private:
+  template <std::size_t... S, std::size_t... B>
+  constexpr table (detail::indices<S...> s, detail::indices<B...> b,
+		   const detail::name_list<N> &names, O... o)
+    : table (s, b, names,
+	     names.find_seed (typename detail::make_indices<N>::type ()), o...)
+  {
+  }
+
+  template <std::size_t... S, std::size_t... B>
+  constexpr table (detail::indices<S...> s, detail::indices<B...> b,
+		   const detail::name_list<N> &names, unsigned long seed,
+		   O... o)
+    : table (s, b, typename detail::make_indices<N>::type (), names, seed,
+	     names.buckets (typename detail::make_indices<N>::type (), seed),
+	     names.ranks (typename detail::make_indices<N>::type ()),
+	     detail::storage<O...> (o...))
+  {
+  }
+
+  template <std::size_t... S, std::size_t... B, std::size_t... I>
+  constexpr table (detail::indices<S...>, detail::indices<B...>,
+		   detail::indices<I...>, const detail::name_list<N> &names,
+		   unsigned long seed, const detail::bucket_list<N> &buckets,
+		   const detail::rank_list<N> &ranks,
+		   const detail::storage<O...> &options)
+    : options_ (options),
+      names_ (names),
+      lens_ { detail::length (names.long_names[I])... },
+      has_arg_ { O::has_arg ()... },
+      shorts_ { (signed char) names.short_index (S)... },
+      seed_ (seed),
+      slots_ { (short) (seed == 0 ? -1 : buckets.slot (B))... },
+      nlong_ (names.count_long ()),
+      order_ { (signed char) ranks.at (I)... },
+      same_ { (signed char) options.find_same
+	      (detail::element<I>::get (options), (int) I)... }
+  {
+  }
+
+  detail::storage<O...> options_;
+  detail::name_list<N> names_;
+  std::size_t lens_[N];
+  int has_arg_[N];
+  signed char shorts_[256];
+  unsigned long seed_;
+  short slots_[HASH_SIZE];
+  /* The options with long names, sorted by name, and for each option the
+     first one that does the same thing.  */
+  std::size_t nlong_;
+  signed char order_[N];
+  signed char same_[N];
+};
+
+template <class O, class... Rest>
+constexpr table<typename O::config_type, O, Rest...>
+make_table (O first, Rest... rest)
+{
+  return table<typename O::config_type, O, Rest...> (first, rest...);
+}
+
+/* Define the constant option table NAME from the options that follow,
+   and check it.  */
+#define GETOPT_TABLE(name, ...)						\
+  constexpr auto name = ::getopt_cxx::make_table (__VA_ARGS__);		\
+  static_assert (name.valid (),						\
+		 #name ": an option without a name or a bad name");	\
+  static_assert (name.short_unique (),					\
+		 #name ": the same option character twice");		\
+  static_assert (name.long_unique (),					\
+		 #name ": the same long name twice");			\
+  static_assert (name.perfect (),					\
+		 #name ": no seed hashes the long names apart")
+
+namespace detail
+{
+
+inline result
+stop (errc e, int argind, const char *option, std::size_t optlen,
+      int noperands)
+{
+  result r = { e, argind, option, optlen, noperands };
+  return r;
+}
+
+} /* namespace detail */
+
+/* Scan ARGV for the options in T, storing what they say in CFG and the
+   indices of the operands in OPERANDS, which has room for ARGC of them
+   or is null.  */
+template <ordering Ord = ordering::environment, class C, class... O>
+result
+parse (const table<C, O...> &t, int argc, const char *const *argv, C &cfg,
+       int *operands)
+{
+  static_assert (Ord != ordering::return_in_order,
+		 "operands can only be collected, not returned in order");
+  bool in_order = (Ord == ordering::require_order
+		   || (Ord == ordering::environment
+		       && std::getenv ("POSIXLY_CORRECT") != nullptr));
+  int n = 0;
+  int i = 1;
+
+  while (i < argc)
+    {
+      const char *a = argv[i];
+
+      if (a[0] != '-' || a[1] == '\0')
+	{
+	  if (operands)
+	    operands[n] = i;
+	  n++;
+	  i++;
+	  /* In REQUIRE_ORDER, the rest are all operands.  */
+	  if (in_order)
+	    for (; i < argc; i++, n++)
+	      if (operands)
+		operands[n] = i;
+	  continue;
+	}
+
+      if (a[1] == '-')
+	{
+	  const char *name = a + 2;
+	  const char *eq = name;
+	  const char *arg = nullptr;
+	  int elt = i++;
+	  bool ambiguous;
+	  int k;
+
+	  if (*name == '\0')
+	    {
+	      for (; i < argc; i++, n++)
+		if (operands)
+		  operands[n] = i;
+	      break;
+	    }
+
+	  while (*eq != '\0' && *eq != '=')
+	    eq++;
+	  k = t.find_long (name, (std::size_t) (eq - name), ambiguous);
+	  if (k < 0)
+	    return detail::stop (ambiguous ? errc::ambiguous : errc::unknown,
+				 elt, a, (std::size_t) (eq - a), n);
+
+	  if (*eq == '=')
+	    {
+	      if (t.has_arg (k) == no_argument)
+		return detail::stop (errc::unexpected_arg, elt, a,
+				     (std::size_t) (eq - a), n);
+	      arg = eq + 1;
+	    }
+	  else if (t.has_arg (k) == required_argument)
+	    {
+	      if (i == argc)
+		return detail::stop (errc::missing_arg, elt, a,
+				     (std::size_t) (eq - a), n);
+	      elt = i;
+	      arg = argv[i++];
+	    }
+
+	  if (!t.apply (k, cfg, arg))
+	    return detail::stop (errc::bad_value, elt, a,
+				 (std::size_t) (eq - a), n);
+	  continue;
+	}
+
+      /* A cluster of option characters.  */
+      for (const char *p = a + 1; *p != '\0'; )
+	{
+	  const char *c = p++;
+	  const char *arg = nullptr;
+	  int elt = i;
+	  int k = t.find_short (*c);
+
+	  if (k < 0)
+	    return detail::stop (errc::unknown, i, c, 1, n);
+
+	  if (t.has_arg (k) != no_argument)
+	    {
+	      if (*p != '\0')
+		arg = p;
+	      else if (t.has_arg (k) == required_argument)
+		{
+		  if (i + 1 == argc)
+		    return detail::stop (errc::missing_arg, i, c, 1, n);
+		  elt = ++i;
+		  arg = argv[i];
+		}
+	      if (!t.apply (k, cfg, arg))
+		return detail::stop (errc::bad_value, elt, c, 1, n);
+	      break;
+	    }
+
+	  t.apply (k, cfg, nullptr);
+	}
+      i++;
+    }
+
+  return detail::stop (errc::none, argc, nullptr, 0, n);
+}
+
+} /* namespace getopt_cxx */
+
+#endif /* getopt.hpp */
@@ -24,6 +24,7 @@
 
 #ifndef HAVE_GETOPT_H
 #include "getopt.h"
+#include "getopt_int.h"
 
 #if !defined __STDC__ || !__STDC__
 /* This is a separate conditional since some stdc systems
@@ -94,6 +95,160 @@ getopt_long_only (argc, argv, options, long_options, opt_index)
 
 #endif	/* Not ELIDE_CODE.  */
 
+/* Reentrant versions of the above, scanning with the state in D
+   instead of the global `optind', `optarg' and `optopt'.  */
+
+int
+getopt_long_r (argc, argv, options, long_options, opt_index, d)
+     int argc;
+     char *const *argv;
+     const char *options;
+     const struct option *long_options;
+     int *opt_index;
+     struct getopt_state *d;
+{
+  return _getopt_internal_r (argc, argv, options, long_options, opt_index,
+			     0, d);
+}
+
+int
+getopt_long_only_r (argc, argv, options, long_options, opt_index, d)
+     int argc;
+     char *const *argv;
+     const char *options;
+     const struct option *long_options;
+     int *opt_index;
+     struct getopt_state *d;
+{
+  return _getopt_internal_r (argc, argv, options, long_options, opt_index,
+			     1, d);
+}
+
+/* The same, for options compiled by `getopt_compile'.  */
+
+int
+getopt_long_spec_r (argc, argv, spec, opt_index, d)
+     int argc;
+     char *const *argv;
+     const struct getopt_spec *spec;
+     int *opt_index;
+     struct getopt_state *d;
+{
+  return _getopt_spec_internal_r (argc, argv, spec, opt_index, 0, d);
+}
+
+int
+getopt_long_only_spec_r (argc, argv, spec, opt_index, d)
+     int argc;
+     char *const *argv;
+     const struct getopt_spec *spec;
+     int *opt_index;
+     struct getopt_state *d;
+{
+  return _getopt_spec_internal_r (argc, argv, spec, opt_index, 1, d);
+}
+
+int
+getopt_long_view_r (argc, views, spec, opt_index, d)
+     int argc;
+     const struct getopt_view *views;
+     const struct getopt_spec *spec;
+     int *opt_index;
+     struct getopt_state *d;
+{
+  return _getopt_view_internal_r (argc, views, spec, opt_index, 0, d);
+}
+
+int
+getopt_long_only_view_r (argc, views, spec, opt_index, d)
+     int argc;
+     const struct getopt_view *views;
+     const struct getopt_spec *spec;
+     int *opt_index;
+     struct getopt_state *d;
+{
+  return _getopt_view_internal_r (argc, views, spec, opt_index, 1, d);
+}
+
+int
+_getopt_parse_events (argc, argv, spec, flags, events, maxevents, d)
+     int argc;
+     char *const *argv;
+     const struct getopt_spec *spec;
+     int flags;
+     struct getopt_event *events;
+     int maxevents;
+     struct getopt_state *d;
+{
+  int long_only = (flags & GETOPT_PARSE_LONG_ONLY) != 0;
+  int nevents = 0;
+  int longind;
+  int c;
+
+  if (flags & GETOPT_PARSE_QUIET)
+    d->opterr = 0;
+
+  for (;;)
+    {
+      longind = -1;
+      c = _getopt_spec_internal_r (argc, argv, spec, &longind, long_only, d);
+      if (c == -1)
+	break;
+      if (nevents < maxevents)
+	{
+	  struct getopt_event *ev = &events[nevents];
+	  ev->opt = c;
+	  ev->longind = longind;
+	  ev->optarg = d->optarg;
+	  ev->argind = d->__argind;
+	}
+      nevents++;
+    }
+  return nevents;
+}
+
+int
+getopt_parse_all (argc, argv, spec, flags, events, maxevents, operind)
+     int argc;
+     char *const *argv;
+     const struct getopt_spec *spec;
+     int flags;
+     struct getopt_event *events;
+     int maxevents;
+     int *operind;
+{
+  struct getopt_state d = GETOPT_STATE_INITIALIZER;
+  int nevents;
+
+  nevents = _getopt_parse_events (argc, argv, spec, flags,
+				  events, maxevents, &d);
+  if (operind != NULL)
+    *operind = argc < 1 ? argc : d.optind;
+  return nevents;
+}
+
+int
+getopt_parse_all_operands (argc, argv, spec, flags, events, maxevents,
+			   operands, noperands)
+     int argc;
+     char *const *argv;
+     const struct getopt_spec *spec;
+     int flags;
+     struct getopt_event *events;
+     int maxevents;
+     int *operands;
+     int *noperands;
+{
+  struct getopt_state d = GETOPT_STATE_INITIALIZER;
+  int nevents;
+
+  d.operands = operands;
+  nevents = _getopt_parse_events (argc, argv, spec, flags,
+				  events, maxevents, &d);
+  *noperands = d.noperands;
+  return nevents;
+}
+
 #ifdef TEST
 
 #include <stdio.h>
@@ -0,0 +1,265 @@
+/* Parallel parsing of many command lines for getopt.
+   This file is distributed under the same terms as getopt.c.
+
+   `getopt_parse_bulk' runs `getopt_parse_all_operands' over a vector of
+   jobs on several threads at once.  Nothing is shared between the scans
+   but the compiled specification, which is immutable, and the job vector,
+   in which every job is written by exactly one thread.
+
+   The jobs are divided among the workers in equal ranges of indices.  A
+   worker takes small batches from the front of its own range; once that
+   is empty, it steals the back half of what is left of another worker's
+   range.  Command lines vary a lot in length, and the stealing keeps all
+   workers busy until the very end without any central queue to contend
+   on.  */
+
+#ifdef WIN32
+# include <windows.h>
+#else
+# include <pthread.h>
+# include <unistd.h>
+#endif
+#include <stdlib.h>
+
+#include "getopt.h"
+#include "getopt_int.h"
+
+/* Jobs a worker takes from its own range at a time.  */
+#define BULK_BATCH	16
+
+#ifdef WIN32
+typedef CRITICAL_SECTION bulk_lock_t;
+# define bulk_lock_init(l)	InitializeCriticalSection (l)
+# define bulk_lock_destroy(l)	DeleteCriticalSection (l)
+# define bulk_lock(l)		EnterCriticalSection (l)
+# define bulk_unlock(l)		LeaveCriticalSection (l)
+#else
+typedef pthread_mutex_t bulk_lock_t;
+# define bulk_lock_init(l)	pthread_mutex_init ((l), NULL)
+# define bulk_lock_destroy(l)	pthread_mutex_destroy (l)
+# define bulk_lock(l)		pthread_mutex_lock (l)
+# define bulk_unlock(l)		pthread_mutex_unlock (l)
+#endif
+
+/* The jobs [lo,hi) not yet taken by anyone.  */
+struct bulk_range
+{
+  bulk_lock_t lock;
+  int lo, hi;
+};
+
+struct bulk
+{
+  struct getopt_job *jobs;
+  const struct getopt_spec *spec;
+  int flags;
+  int nworkers;
+  struct bulk_range *ranges;
+};
+
+struct bulk_worker
+{
+  struct bulk *bulk;
+  int self;
+#ifdef WIN32
+  HANDLE thread;
+#else
+  pthread_t thread;
+#endif
+  int started;
+};
+
+static void
+collect_error (void *cookie, const struct getopt_error *err)
+{
+  struct getopt_job *job = (struct getopt_job *) cookie;
+
+  if (job->nerrors < job->maxerrors)
+    job->errors[job->nerrors] = *err;
+  job->nerrors++;
+}
+
+static void
+parse_job (struct getopt_job *job, const struct getopt_spec *spec, int flags)
+{
+  struct getopt_state d = GETOPT_STATE_INITIALIZER;
+
+  d.operands = job->operands;
+  d.error = collect_error;
+  d.error_cookie = job;
+  job->nerrors = 0;
+  job->nevents = _getopt_parse_events (job->argc, job->argv, spec, flags,
+				       job->events, job->maxevents, &d);
+  job->noperands = d.noperands;
+}
+
+/* Take a batch of jobs from the front of range SELF.  */
+
+static int
+take (struct bulk *b, int self, int *lo, int *hi)
+{
+  struct bulk_range *r = &b->ranges[self];
+
+  bulk_lock (&r->lock);
+  *lo = r->lo;
+  *hi = r->hi - r->lo > BULK_BATCH ? r->lo + BULK_BATCH : r->hi;
+  r->lo = *hi;
+  bulk_unlock (&r->lock);
+  return *lo < *hi;
+}
+
+/* Move the back half of some other worker's range into range SELF, which
+   is empty.  Fails when every range is.  */
+
+static int
+steal (struct bulk *b, int self)
+{
+  int i;
+
+  for (i = 1; i < b->nworkers; i++)
+    {
+      struct bulk_range *victim = &b->ranges[(self + i) % b->nworkers];
+      int lo, hi;
+
+      bulk_lock (&victim->lock);
+      hi = victim->hi;
+      lo = victim->lo + (victim->hi - victim->lo) / 2;
+      victim->hi = lo;
+      bulk_unlock (&victim->lock);
+
+      if (lo < hi)
+	{
+	  bulk_lock (&b->ranges[self].lock);
+	  b->ranges[self].lo = lo;
+	  b->ranges[self].hi = hi;
+	  bulk_unlock (&b->ranges[self].lock);
+	  return 1;
+	}
+    }
+  return 0;
+}
+
+static void
+work (struct bulk *b, int self)
+{
+  int lo, hi;
+
+  do
+    while (take (b, self, &lo, &hi))
+      for (; lo < hi; lo++)
+	parse_job (&b->jobs[lo], b->spec, b->flags);
+  while (steal (b, self));
+}
+
+#ifdef WIN32
+static DWORD WINAPI
+worker_main (LPVOID arg)
+{
+  struct bulk_worker *w = (struct bulk_worker *) arg;
+  work (w->bulk, w->self);
+  return 0;
+}
+#else
+static void *
+worker_main (void *arg)
+{
+  struct bulk_worker *w = (struct bulk_worker *) arg;
+  work (w->bulk, w->self);
+  return NULL;
+}
+#endif
+
+static int
+online_cpus (void)
+{
+#ifdef WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo (&info);
+  return (int) info.dwNumberOfProcessors;
+#elif defined _SC_NPROCESSORS_ONLN
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int) n : 1;
+#else
+  return 1;
+#endif
+}
+
+int
+getopt_parse_bulk (struct getopt_job *jobs, int njobs,
+		   const struct getopt_spec *spec, int flags, int nthreads)
+{
+  struct bulk b;
+  struct bulk_worker *workers;
+  int nfailed;
+  int i;
+
+  if (nthreads <= 0)
+    nthreads = online_cpus ();
+  if (nthreads > (njobs + BULK_BATCH - 1) / BULK_BATCH)
+    nthreads = (njobs + BULK_BATCH - 1) / BULK_BATCH;
+  if (nthreads < 1)
+    nthreads = 1;
+
+  b.jobs = jobs;
+  b.spec = spec;
+  b.flags = flags;
+  b.nworkers = nthreads;
+  b.ranges = (struct bulk_range *) malloc (nthreads * sizeof *b.ranges);
+  workers = (struct bulk_worker *) malloc (nthreads * sizeof *workers);
+  if (b.ranges == NULL || workers == NULL)
+    {
+      /* Do it all on this thread.  */
+      free (b.ranges);
+      free (workers);
+      for (i = 0; i < njobs; i++)
+	parse_job (&jobs[i], spec, flags);
+      goto count;
+    }
+
+  for (i = 0; i < nthreads; i++)
+    {
+      bulk_lock_init (&b.ranges[i].lock);
+      b.ranges[i].lo = (int) ((long long) njobs * i / nthreads);
+      b.ranges[i].hi = (int) ((long long) njobs * (i + 1) / nthreads);
+      workers[i].bulk = &b;
+      workers[i].self = i;
+      workers[i].started = 0;
+    }
+
+  /* The calling thread is worker 0.  If another one cannot be started,
+     its range is stolen by those that were.  */
+  for (i = 1; i < nthreads; i++)
+    {
+#ifdef WIN32
+      workers[i].thread = CreateThread (NULL, 0, worker_main, &workers[i],
+					0, NULL);
+      workers[i].started = workers[i].thread != NULL;
+#else
+      workers[i].started = pthread_create (&workers[i].thread, NULL,
+					   worker_main, &workers[i]) == 0;
+#endif
+    }
+  work (&b, 0);
+  for (i = 1; i < nthreads; i++)
+    if (workers[i].started)
+      {
+#ifdef WIN32
+	WaitForSingleObject (workers[i].thread, INFINITE);
+	CloseHandle (workers[i].thread);
+#else
+	pthread_join (workers[i].thread, NULL);
+#endif
+      }
+
+  for (i = 0; i < nthreads; i++)
+    bulk_lock_destroy (&b.ranges[i].lock);
+  free (b.ranges);
+  free (workers);
+
+ count:
+  nfailed = 0;
+  for (i = 0; i < njobs; i++)
+    if (jobs[i].nerrors > 0)
+      nfailed++;
+  return nfailed;
+}
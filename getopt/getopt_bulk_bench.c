@@ -0,0 +1,138 @@
+// throughput of getopt_parse_bulk by thread count
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+# include <windows.h>
+#endif
+
+static struct option long_options[] =
+{
+    {"add", required_argument, 0, 'a'},
+    {"append", no_argument, 0, 0},
+    {"delete", required_argument, 0, 0},
+    {"verbose", optional_argument, 0, 0},
+    {"create", no_argument, 0, 0},
+    {"file", required_argument, 0, 0},
+    {"help", no_argument, 0, 0},
+    {0, 0, 0, 0}
+};
+
+static char simple_options[] = "a:bc::d:0123456789";
+
+// a mix of options, arguments, operands and the odd mistake
+static char *tokens[] =
+{
+    "-a", "value", "-b", "-c", "-cfoo", "-d", "17", "-b9", "--add=x",
+    "--append", "--delete", "item", "--verbose", "--verbose=3", "--cr",
+    "--file", "/tmp/input", "--he", "operand", "another-operand", "-",
+    "--ap", "-x", "--nope",
+};
+
+#define NTOKENS (sizeof(tokens) / sizeof(tokens[0]))
+#define MAXARGS 32
+
+// a monotonic clock: the wall clock can step, and is coarse on some hosts
+double now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER t, f;
+    QueryPerformanceCounter(&t);
+    QueryPerformanceFrequency(&f);
+    return (double)t.QuadPart / f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+void usage(void)
+{
+    printf("usage: getopt_bulk_bench [jobs] [max threads] [rounds]\n");
+}
+
+int main(int argc, char **argv)
+{
+    int njobs = argc > 1 ? atoi(argv[1]) : 200000;
+    int maxthreads = argc > 2 ? atoi(argv[2]) : 8;
+    int rounds = argc > 3 ? atoi(argv[3]) : 5;
+    struct getopt_spec *spec = getopt_compile(simple_options, long_options);
+    struct getopt_job *jobs;
+    char **args;
+    struct getopt_event *events;
+    int *operands;
+    struct getopt_error *errors;
+    double base = 0;
+    int i, j, threads;
+
+    if (njobs <= 0 || maxthreads <= 0 || rounds <= 0 || !spec)
+    {
+        usage();
+        return 1;
+    }
+
+    jobs = (struct getopt_job *)calloc(njobs, sizeof(*jobs));
+    args = (char **)malloc((size_t)njobs * (MAXARGS + 1) * sizeof(char *));
+    events = (struct getopt_event *)malloc((size_t)njobs * MAXARGS * sizeof(*events));
+    operands = (int *)malloc((size_t)njobs * MAXARGS * sizeof(int));
+    errors = (struct getopt_error *)malloc((size_t)njobs * 4 * sizeof(*errors));
+    if (!jobs || !args || !events || !operands || !errors)
+    {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    // the same pseudo-random command lines for every run
+    srand(1);
+    for (i = 0; i < njobs; ++i)
+    {
+        struct getopt_job *job = &jobs[i];
+        char **v = &args[(size_t)i * (MAXARGS + 1)];
+
+        job->argc = 2 + rand() % (MAXARGS - 2);
+        v[0] = "bench";
+        for (j = 1; j < job->argc; ++j)
+            v[j] = tokens[rand() % NTOKENS];
+        v[job->argc] = NULL;
+
+        job->argv = v;
+        job->events = &events[(size_t)i * MAXARGS];
+        job->maxevents = MAXARGS;
+        job->operands = &operands[(size_t)i * MAXARGS];
+        job->errors = &errors[(size_t)i * 4];
+        job->maxerrors = 4;
+    }
+
+    for (threads = 1; threads <= maxthreads; threads *= 2)
+    {
+        double best = 0;
+        int failed = 0;
+
+        for (i = 0; i < rounds; ++i)
+        {
+            double start = now();
+            failed = getopt_parse_bulk(jobs, njobs, spec, 0, threads);
+            double elapsed = now() - start;
+            if (best == 0 || elapsed < best)
+                best = elapsed;
+        }
+
+        if (threads == 1)
+            base = best;
+        printf("threads %2d: %10.0f lines/s  speedup %5.2f  (%d lines with errors)\n",
+               threads, njobs / best, base / best, failed);
+    }
+
+    getopt_spec_free(spec);
+    free(jobs);
+    free(args);
+    free(events);
+    free(operands);
+    free(errors);
+    return 0;
+}
@@ -0,0 +1,125 @@
+/* Subcommands for getopt.
+   This file is distributed under the same terms as getopt.c.
+
+   A program with many subcommands could put the options of all of them
+   into one LONGOPTS, but then every long option is looked up among all
+   of them, and compiling them all costs the same whichever subcommand is
+   run.  A `struct getopt_commands' is instead a hash table of the verbs,
+   built from the names alone, next to a compiled specification for each
+   subcommand that stays null until the subcommand is first asked for.  */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "getopt.h"
+#include "getopt_int.h"
+
+struct getopt_commands
+{
+  const struct getopt_command *commands;
+  int ncommands;
+  int *slots;			/* Open addressing, -1 for a free slot.  */
+  unsigned long mask;		/* The number of slots minus one.  */
+  struct getopt_spec **specs;	/* Compiled on first use.  */
+};
+
+static unsigned long
+hash_name (const char *name)
+{
+  unsigned long h = 2166136261ul;
+
+  while (*name)
+    h = ((h ^ (unsigned char) *name++) * 16777619ul) & 0xfffffffful;
+  return h;
+}
+
+struct getopt_commands *
+getopt_commands_new (const struct getopt_command *commands)
+{
+  struct getopt_commands *cmds;
+  unsigned long nslots = 1;
+  int i;
+
+  cmds = (struct getopt_commands *) malloc (sizeof *cmds);
+  if (cmds == NULL)
+    return NULL;
+  for (i = 0; commands[i].name; i++)
+    /* Count them.  */ ;
+  cmds->commands = commands;
+  cmds->ncommands = i;
+
+  /* At most half full, so that probe sequences stay short.  */
+  while (nslots < 2 * (unsigned long) cmds->ncommands)
+    nslots *= 2;
+  cmds->mask = nslots - 1;
+  cmds->slots = (int *) malloc (nslots * sizeof *cmds->slots);
+  cmds->specs = (struct getopt_spec **)
+    calloc (cmds->ncommands + 1, sizeof *cmds->specs);
+  if (cmds->slots == NULL || cmds->specs == NULL)
+    {
+      free (cmds->slots);
+      free (cmds->specs);
+      free (cmds);
+      return NULL;
+    }
+
+  memset (cmds->slots, -1, nslots * sizeof *cmds->slots);
+  for (i = 0; i < cmds->ncommands; i++)
+    {
+      unsigned long h = hash_name (commands[i].name) & cmds->mask;
+
+      /* The first of several commands with the same name wins, as with a
+	 search from the start of the array.  */
+      while (cmds->slots[h] >= 0
+	     && strcmp (commands[cmds->slots[h]].name, commands[i].name))
+	h = (h + 1) & cmds->mask;
+      if (cmds->slots[h] < 0)
+	cmds->slots[h] = i;
+    }
+  return cmds;
+}
+
+void
+getopt_commands_free (struct getopt_commands *cmds)
+{
+  int i;
+
+  if (cmds == NULL)
+    return;
+  for (i = 0; i < cmds->ncommands; i++)
+    getopt_spec_free (cmds->specs[i]);
+  free (cmds->specs);
+  free (cmds->slots);
+  free (cmds);
+}
+
+int
+getopt_commands_find (const struct getopt_commands *cmds, const char *name)
+{
+  unsigned long h = hash_name (name) & cmds->mask;
+
+  while (cmds->slots[h] >= 0)
+    {
+      if (!strcmp (cmds->commands[cmds->slots[h]].name, name))
+	return cmds->slots[h];
+      h = (h + 1) & cmds->mask;
+    }
+  return -1;
+}
+
+const struct getopt_spec *
+getopt_commands_spec (struct getopt_commands *cmds, int index)
+{
+  const struct getopt_command *cmd;
+
+  if (index < 0 || index >= cmds->ncommands)
+    return NULL;
+  if (cmds->specs[index] == NULL)
+    {
+      cmd = &cmds->commands[index];
+      cmds->specs[index] = getopt_compile (cmd->optstring != NULL
+					   ? cmd->optstring : "",
+					   cmd->longopts);
+    }
+  return cmds->specs[index];
+}
@@ -0,0 +1,149 @@
+// test getopt_commands: a git-style program with subcommands
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static struct option global_options[] =
+{
+    {"help", no_argument, 0, 'h'},
+    {"verbose", no_argument, 0, 'v'},
+    {0, 0, 0, 0}
+};
+
+static struct option add_options[] =
+{
+    {"force", no_argument, 0, 'f'},
+    {"dry-run", no_argument, 0, 'n'},
+    {0, 0, 0, 0}
+};
+
+static struct option commit_options[] =
+{
+    {"message", required_argument, 0, 'm'},
+    {"amend", no_argument, 0, 0},
+    {"all", no_argument, 0, 'a'},
+    {0, 0, 0, 0}
+};
+
+static struct option log_options[] =
+{
+    {"max-count", required_argument, 0, 'n'},
+    {"oneline", no_argument, 0, 0},
+    {"author", required_argument, 0, 0},
+    {0, 0, 0, 0}
+};
+
+static struct getopt_command commands[] =
+{
+    {"add", "fn", add_options, 0},
+    {"commit", "m:a", commit_options, 0},
+    {"log", "n:", log_options, 0},
+    {"status", "s", 0, 0},
+    {0, 0, 0, 0}
+};
+
+void usage()
+{
+    struct getopt_command *cmd;
+
+    printf("usage: getopt_command_test [--help] [--verbose] <command> [<options>]\n");
+    printf("commands:");
+    for(cmd = commands; cmd->name; ++cmd)
+        printf(" %s", cmd->name);
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    struct getopt_state sub = GETOPT_STATE_INITIALIZER;
+    struct getopt_commands *cmds;
+    struct getopt_nameindex *names = 0;
+    const struct getopt_spec *spec;
+    int c, index, longindex;
+
+    // the global options stop at the verb
+    while ((c = getopt_long_r(argc, argv, "+hv", global_options, 0, &state)) != -1)
+    {
+        if (c == 'h')
+            usage();
+        else if (c == 'v')
+            printf("verbose\n");
+    }
+
+    if (state.optind == argc)
+    {
+        usage();
+        return 1;
+    }
+
+    cmds = getopt_commands_new(commands);
+    if (!cmds)
+        return 1;
+
+    index = getopt_commands_find(cmds, argv[state.optind]);
+    if (index < 0)
+    {
+        int nearest[GETOPT_MAX_SUGGESTIONS];
+        int i, n;
+
+        printf("'%s' is not a command\n", argv[state.optind]);
+
+        // the same index as for misspelled options, over the verbs
+        names = getopt_nameindex_new(&commands[0].name, -1, sizeof(commands[0]));
+        n = names ? getopt_nameindex_nearest(names, argv[state.optind],
+                                             strlen(argv[state.optind]), 2,
+                                             nearest, GETOPT_MAX_SUGGESTIONS) : 0;
+        for (i = 0; i < n; ++i)
+            printf("%s %s", i ? "," : "did you mean", commands[nearest[i]].name);
+        if (n)
+            printf("?\n");
+        getopt_nameindex_free(names);
+        getopt_commands_free(cmds);
+        return 1;
+    }
+
+    // only this command's options are ever compiled
+    spec = getopt_commands_spec(cmds, index);
+    if (!spec)
+    {
+        getopt_commands_free(cmds);
+        return 1;
+    }
+
+    // misspelled long options get suggestions in the error message
+    if (commands[index].longopts)
+        names = getopt_nameindex_new(&commands[index].longopts[0].name, -1,
+                                     sizeof(struct option));
+    sub.nameindex = names;
+
+    printf("command %s\n", commands[index].name);
+    argc -= state.optind;
+    argv += state.optind;
+    while ((c = getopt_long_spec_r(argc, argv, spec, &longindex, &sub)) != -1)
+    {
+        if (c == '?')
+            continue;
+        if (c == 0)
+            printf("option %s", commands[index].longopts[longindex].name);
+        else
+            printf("option %c", c);
+        if (sub.optarg)
+            printf(" with arg %s", sub.optarg);
+        printf("\n");
+    }
+
+    if (sub.optind < argc)
+    {
+        printf("non-option ARGV-elements: ");
+        while (sub.optind < argc)
+            printf("%s ", argv[sub.optind++]);
+        printf("\n");
+    }
+
+    getopt_nameindex_free(names);
+    getopt_commands_free(cmds);
+    return 0;
+}
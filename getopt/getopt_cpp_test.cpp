@@ -0,0 +1,315 @@
+// test getopt.hpp: the options of getopt_test, declared once, and a
+// cross-check of its scans against getopt_long_r
+
+#include <getopt.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct config
+{
+    const char *add;
+    bool b;
+    const char *c;
+    int digits;
+    bool append;
+    std::string del;
+    int verbose;
+    bool create;
+    const char *file;
+    bool help;
+};
+
+GETOPT_TABLE(options,
+    getopt_cxx::value('a', "add", &config::add),
+    getopt_cxx::flag('b', nullptr, &config::b),
+    getopt_cxx::optional_value('c', nullptr, &config::c, ""),
+    getopt_cxx::value('d', "delete", &config::del),
+    getopt_cxx::count('0', nullptr, &config::digits),
+    getopt_cxx::count('1', nullptr, &config::digits),
+    getopt_cxx::count('2', nullptr, &config::digits),
+    getopt_cxx::flag(0, "append", &config::append),
+    getopt_cxx::optional_value(0, "verbose", &config::verbose, 1),
+    getopt_cxx::flag(0, "create", &config::create),
+    getopt_cxx::value(0, "file", &config::file),
+    getopt_cxx::flag(0, "help", &config::help));
+
+// the long names are found by a perfect hash chosen by the compiler
+static_assert(options.perfect(), "no perfect hash for the long names");
+
+// the same options for getopt_long_r
+static struct option long_options[] =
+{
+    {"add", required_argument, 0, 'a'},
+    {"delete", required_argument, 0, 'd'},
+    {"append", no_argument, 0, 0},
+    {"verbose", optional_argument, 0, 0},
+    {"create", no_argument, 0, 0},
+    {"file", required_argument, 0, 0},
+    {"help", no_argument, 0, 0},
+    {0, 0, 0, 0}
+};
+
+static void apply_option(config &cfg, int c, int option_index, const char *arg)
+{
+    switch (c)
+    {
+    case 'a':
+        cfg.add = arg;
+        break;
+    case 'b':
+        cfg.b = true;
+        break;
+    case 'c':
+        cfg.c = arg ? arg : "";
+        break;
+    case 'd':
+        cfg.del = arg;
+        break;
+    case '0':
+    case '1':
+    case '2':
+        cfg.digits++;
+        break;
+    case 0:
+        switch (option_index)
+        {
+        case 2:
+            cfg.append = true;
+            break;
+        case 3:
+            cfg.verbose = arg ? atoi(arg) : 1;
+            break;
+        case 4:
+            cfg.create = true;
+            break;
+        case 5:
+            cfg.file = arg;
+            break;
+        case 6:
+            cfg.help = true;
+            break;
+        }
+        break;
+    }
+}
+
+static bool same_string(const char *a, const char *b)
+{
+    return a == b || (a && b && !strcmp(a, b));
+}
+
+static bool same_config(const config &x, const config &y)
+{
+    return same_string(x.add, y.add) && x.b == y.b && same_string(x.c, y.c)
+        && x.del == y.del && x.digits == y.digits && x.append == y.append
+        && x.verbose == y.verbose && x.create == y.create
+        && same_string(x.file, y.file) && x.help == y.help;
+}
+
+// an abbreviation of two names that do the same thing is not ambiguous
+struct level
+{
+    int verbose;
+    bool quiet;
+    bool quick;
+};
+
+GETOPT_TABLE(aliases,
+    getopt_cxx::count('v', "verbose", &level::verbose),
+    getopt_cxx::count(0, "verbosity", &level::verbose),
+    getopt_cxx::flag('q', "quiet", &level::quiet),
+    getopt_cxx::flag(0, "quick", &level::quick));
+
+static struct option alias_options[] =
+{
+    {"verbose", no_argument, 0, 'v'},
+    {"verbosity", no_argument, 0, 'v'},
+    {"quiet", no_argument, 0, 'q'},
+    {"quick", no_argument, 0, 'Q'},
+    {0, 0, 0, 0}
+};
+
+static void apply_alias(level &lvl, int c, int, const char *)
+{
+    if (c == 'v')
+        lvl.verbose++;
+    else if (c == 'q')
+        lvl.quiet = true;
+    else if (c == 'Q')
+        lvl.quick = true;
+}
+
+static bool same_level(const level &x, const level &y)
+{
+    return x.verbose == y.verbose && x.quiet == y.quiet && x.quick == y.quick;
+}
+
+// command lines, each ending in a null; the first word is the program
+static const char *const cases[][10] =
+{
+    {"p", "-a", "x", "foo", "-b", 0},
+    {"p", "foo", "-b", "--", "-c", 0},
+    {"p", "-cval", "--ap", "bar", 0},
+    {"p", "-b01", "2", "-d", "z", "bar", "-", "--verbose=3", 0},
+    {"p", "--add=v", "--del", "d", "--verb", "--create", "baz", 0},
+    {"p", "--he", "--fi", "name", "--", "--help", 0},
+    {"p", "--a", 0},
+    {"p", "--=x", 0},
+    {"p", "-a", 0},
+    {"p", "op", "--file", 0},
+    {"p", "--append=1", 0},
+    {"p", "-bx", 0},
+    {"p", "--nope", "op", 0},
+    {"p", "op", "--cr=x", 0},
+    {"p", "--verb", "-v", "--verbosi", "op", "--quie", 0},
+    {"p", "--qui", 0},
+    {"p", "--q", "op", "-q", 0},
+};
+
+static void record_error(void *cookie, const struct getopt_error *err)
+{
+    struct getopt_error *first = (struct getopt_error *)cookie;
+    if (first->code == 0)
+        *first = *err;
+}
+
+// scan ARGV with T and with getopt_long_r, and compare what they found
+template <getopt_cxx::ordering Ord, class T, class C>
+static bool cross_check(const T &t, const char *optstring,
+                        const struct option *longopts,
+                        void (*apply)(C &, int, int, const char *),
+                        bool (*same)(const C &, const C &),
+                        const char *const *argv)
+{
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    struct getopt_error first;
+    C x = C(), y = C();
+    int argc = 0;
+    int option_index, c, i;
+
+    while (argv[argc])
+        ++argc;
+    std::vector<int> xops(argc), yops(argc);
+
+    getopt_cxx::result r = getopt_cxx::parse<Ord>(t, argc, argv, x, xops.data());
+
+    // the operands are listed rather than moved, so ARGV is not written to
+    memset(&first, 0, sizeof(first));
+    state.operands = yops.data();
+    state.error = record_error;
+    state.error_cookie = &first;
+    while ((c = getopt_long_r(argc, const_cast<char *const *>(argv), optstring,
+                              longopts, &option_index, &state)) != -1)
+        if (c != '?' && c != ':')
+            apply(y, c, option_index, state.optarg);
+    getopt_state_release(&state);
+
+    if (!r)
+        return (int)r.error == first.code && r.argind == first.argind;
+    if (first.code != 0 || r.noperands != state.noperands || !same(x, y))
+        return false;
+    for (i = 0; i < r.noperands; ++i)
+        if (xops[i] != yops[i])
+            return false;
+    return true;
+}
+
+// every case in every ordering both support; returns the number that differ
+static int cross_check_all()
+{
+    int failed = 0;
+    size_t i;
+    int j;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+    {
+        bool ok[4] =
+        {
+            cross_check<getopt_cxx::ordering::environment>(
+                options, "a:bc::d:012", long_options, apply_option,
+                same_config, cases[i]),
+            cross_check<getopt_cxx::ordering::require_order>(
+                options, "+a:bc::d:012", long_options, apply_option,
+                same_config, cases[i]),
+            cross_check<getopt_cxx::ordering::environment>(
+                aliases, "vq", alias_options, apply_alias, same_level,
+                cases[i]),
+            cross_check<getopt_cxx::ordering::require_order>(
+                aliases, "+vq", alias_options, apply_alias, same_level,
+                cases[i]),
+        };
+
+        for (j = 0; j < 4; ++j)
+            if (!ok[j])
+            {
+                printf("case %d, check %d: differs from getopt_long_r\n",
+                       (int)i, j);
+                failed++;
+            }
+    }
+    printf("cross-check: %d cases, %d differ\n",
+           (int)(sizeof(cases) / sizeof(cases[0])), failed);
+    return failed;
+}
+
+void usage()
+{
+    printf("usage: getopt_cpp_test [-a arg] [-b] [-c[arg]] [-d arg] [-012] "
+           "[--add arg] [--append] [--delete arg] [--verbose[=level]] "
+           "[--create] [--file arg] [--help]\n");
+}
+
+int main(int argc, char **argv)
+{
+    config cfg = config();
+    std::vector<int> operands(argc);
+    getopt_cxx::result r;
+    int i;
+
+    if (argc == 1)
+    {
+        usage();
+        return cross_check_all() != 0;
+    }
+
+    r = getopt_cxx::parse(options, argc, argv, cfg, operands.data());
+    if (!r)
+    {
+        printf("argv[%d]: %s '%.*s'\n", r.argind,
+               getopt_cxx::describe(r.error), (int)r.optlen, r.option);
+        return 1;
+    }
+
+    if (cfg.add)
+        printf("add '%s'\n", cfg.add);
+    if (cfg.b)
+        printf("option b\n");
+    if (cfg.c)
+        printf("option c with value '%s'\n", cfg.c);
+    if (!cfg.del.empty())
+        printf("delete '%s'\n", cfg.del.c_str());
+    if (cfg.digits)
+        printf("%d digit options\n", cfg.digits);
+    if (cfg.append)
+        printf("append\n");
+    if (cfg.verbose)
+        printf("verbose level %d\n", cfg.verbose);
+    if (cfg.create)
+        printf("create\n");
+    if (cfg.file)
+        printf("file '%s'\n", cfg.file);
+    if (cfg.help)
+        usage();
+
+    if (r.noperands > 0)
+    {
+        printf("non-option ARGV-elements: ");
+        for (i = 0; i < r.noperands; ++i)
+            printf("%s ", argv[operands[i]]);
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,426 @@
+// getopt_gen: write a matcher specialized for one set of options
+//
+// usage: getopt_gen spec prefix out.c out.h
+//
+// The spec file has one declaration per line; blank lines and lines
+// starting with '#' are ignored:
+//
+//     optstring a:bc::d:0123456789
+//     long add required 'a'
+//     long append no 0
+//     long brief no &verbose_flag 0
+//
+// "long" takes the name, no/required/optional, an optional &variable for
+// the flag member and the value, a character in quotes or a number.
+//
+// out.c defines prefix_longopts and prefix_optstring, a static struct
+// getopt_spec with the option characters already classified, and, for
+// the long names, a function that walks them as nested switches on one
+// character at a time.  prefix_getopt_long_r and prefix_getopt_long_only_r
+// take the arguments and give the results of getopt_long_r with that
+// optstring and those longopts.
+
+#include <getopt.h>
+#include <getopt_int.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXOPTS 1024
+#define MAXLINE 1024
+
+struct longopt
+{
+    char *name;
+    int has_arg;
+    char *flag;     // the variable, without '&', or NULL
+    int val;
+};
+
+static char *optstring;
+static struct longopt opts[MAXOPTS];
+static int nopts;
+
+void usage(void)
+{
+    fprintf(stderr, "usage: getopt_gen spec prefix out.c out.h\n");
+}
+
+void fail(const char *file, int line, const char *msg)
+{
+    fprintf(stderr, "%s:%d: %s\n", file, line, msg);
+    exit(1);
+}
+
+char *copy(const char *s)
+{
+    char *r = (char *)malloc(strlen(s) + 1);
+    if (!r)
+    {
+        fprintf(stderr, "getopt_gen: out of memory\n");
+        exit(1);
+    }
+    return strcpy(r, s);
+}
+
+// a number, or a character between single quotes
+int parse_val(const char *s, int *val)
+{
+    char *end;
+
+    if (s[0] == '\'')
+    {
+        if (s[1] == '\0' || s[2] != '\'' || s[3] != '\0')
+            return 0;
+        *val = (unsigned char)s[1];
+        return 1;
+    }
+    *val = (int)strtol(s, &end, 0);
+    return end != s && *end == '\0';
+}
+
+void read_spec(const char *file)
+{
+    FILE *in = fopen(file, "r");
+    char buf[MAXLINE];
+    int line = 0;
+
+    if (!in)
+    {
+        perror(file);
+        exit(1);
+    }
+
+    while (fgets(buf, sizeof(buf), in))
+    {
+        char *words[6];
+        int nwords = 0;
+        char *p = strtok(buf, " \t\r\n");
+
+        ++line;
+        if (!p || p[0] == '#')
+            continue;
+        while (p && nwords < 6)
+        {
+            words[nwords++] = p;
+            p = strtok(NULL, " \t\r\n");
+        }
+
+        if (!strcmp(words[0], "optstring"))
+        {
+            if (nwords != 2)
+                fail(file, line, "optstring takes one word");
+            optstring = copy(words[1]);
+        }
+        else if (!strcmp(words[0], "long"))
+        {
+            struct longopt *o = &opts[nopts];
+
+            if (nwords != 4 && !(nwords == 5 && words[3][0] == '&'))
+                fail(file, line, "long takes a name, an argument kind, "
+                                 "maybe a &flag, and a value");
+            if (nopts == MAXOPTS)
+                fail(file, line, "too many long options");
+            if (strchr(words[1], '='))
+                fail(file, line, "a long name cannot contain '='");
+
+            o->name = copy(words[1]);
+            if (!strcmp(words[2], "no"))
+                o->has_arg = no_argument;
+            else if (!strcmp(words[2], "required"))
+                o->has_arg = required_argument;
+            else if (!strcmp(words[2], "optional"))
+                o->has_arg = optional_argument;
+            else
+                fail(file, line, "the argument kind is no, required or optional");
+            o->flag = nwords == 5 ? copy(words[3] + 1) : NULL;
+            if (!parse_val(words[nwords - 1], &o->val))
+                fail(file, line, "the value is a number or a quoted character");
+            ++nopts;
+        }
+        else
+            fail(file, line, "expected optstring or long");
+    }
+    fclose(in);
+
+    if (!optstring)
+        optstring = copy("");
+}
+
+void put_string(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s; ++s)
+    {
+        if (*s == '"' || *s == '\\')
+            fprintf(out, "\\%c", *s);
+        else if (isprint((unsigned char)*s))
+            fputc(*s, out);
+        else
+            fprintf(out, "\\%03o", (unsigned char)*s);
+    }
+    fputc('"', out);
+}
+
+void put_char(FILE *out, int c)
+{
+    if (c >= 0 && c < 256 && isalnum(c))
+        fprintf(out, "'%c'", c);
+    else
+        fprintf(out, "%d", c);
+}
+
+// whether a name abbreviating both could mean either, as in getopt.c
+int equivalent(const struct longopt *a, const struct longopt *b)
+{
+    return a->has_arg == b->has_arg && a->val == b->val
+        && (a->flag == b->flag || (a->flag && b->flag && !strcmp(a->flag, b->flag)));
+}
+
+// the lookup for the names starting with the DEPTH characters at PREFIX:
+// the same answers as the trie of getopt_index.c
+void put_node(FILE *out, const char *prefix, size_t depth, int indent)
+{
+    int first = -1, exact = -1, count = 0, ambig = 0;
+    int next[256] = {0};
+    int i, c;
+
+    for (i = 0; i < nopts; ++i)
+    {
+        if (strncmp(opts[i].name, prefix, depth))
+            continue;
+        if (first < 0)
+            first = i;
+        if (exact < 0 && opts[i].name[depth] == '\0')
+            exact = i;
+        if (!equivalent(&opts[i], &opts[first]))
+            ambig = 1;
+        if (opts[i].name[depth] && !next[(unsigned char)opts[i].name[depth]])
+            next[(unsigned char)opts[i].name[depth]] = i + 1;
+        ++count;
+    }
+
+    fprintf(out, "%*sif (namelen == %lu)\n", indent, "", (unsigned long)depth);
+    if (exact >= 0)
+    {
+        fprintf(out, "%*s  {\n", indent, "");
+        fprintf(out, "%*s    *exact = 1;\n", indent, "");
+        fprintf(out, "%*s    return %d;\n", indent, "", exact);
+        fprintf(out, "%*s  }\n", indent, "");
+    }
+    else if (count > 1)
+    {
+        fprintf(out, "%*s  {\n", indent, "");
+        fprintf(out, "%*s    *ambig = %s;\n", indent, "", ambig ? "1" : "strict");
+        fprintf(out, "%*s    return %d;\n", indent, "", first);
+        fprintf(out, "%*s  }\n", indent, "");
+    }
+    else
+        fprintf(out, "%*s  return %d;\n", indent, "", first);
+
+    for (c = 0; c < 256 && !next[c]; ++c)
+        ;
+    if (c < 256)
+    {
+        fprintf(out, "%*sswitch ((unsigned char) name[%lu])\n", indent, "",
+                (unsigned long)depth);
+        fprintf(out, "%*s  {\n", indent, "");
+        for (; c < 256; ++c)
+        {
+            if (!next[c])
+                continue;
+            fprintf(out, "%*s  case ", indent, "");
+            put_char(out, c);
+            fprintf(out, ":\n");
+            put_node(out, opts[next[c] - 1].name, depth + 1, indent + 4);
+        }
+        fprintf(out, "%*s  }\n", indent, "");
+    }
+    fprintf(out, "%*sreturn -1;\n", indent, "");
+}
+
+void put_spec(FILE *out, const char *prefix, const unsigned char *shortopts,
+              const char *ordering, int posixly_correct, size_t skip)
+{
+    int c;
+
+    fprintf(out, "  {\n");
+    fprintf(out, "    %s_optstring + %lu,\n", prefix, (unsigned long)skip);
+    fprintf(out, "    %s_longopts,\n", prefix);
+    fprintf(out, "    NULL,\n");
+    fprintf(out, "    %s_match,\n", prefix);
+    fprintf(out, "    %s,\n", ordering);
+    fprintf(out, "    %d,\n", posixly_correct);
+    fprintf(out, "    %d,\n", optstring[skip] == ':');
+    fprintf(out, "    {");
+    for (c = 0; c < 256; ++c)
+        fprintf(out, "%s%d%s", c % 16 ? " " : "\n      ", shortopts[c], c < 255 ? "," : "");
+    fprintf(out, "\n    }\n");
+    fprintf(out, "  }");
+}
+
+void write_source(FILE *out, const char *spec, const char *prefix, const char *header)
+{
+    const char *normal = "PERMUTE", *posix = "REQUIRE_ORDER";
+    struct getopt_spec *compiled;
+    size_t skip = 0;
+    int flags = 0;
+    int i;
+
+    if (optstring[0] == '-')
+        normal = posix = "RETURN_IN_ORDER";
+    else if (optstring[0] == '+')
+        normal = posix = "REQUIRE_ORDER";
+    if (optstring[0] == '-' || optstring[0] == '+')
+        skip = 1;
+
+    // the library classifies the option characters, so the tables agree
+    compiled = getopt_compile(optstring, NULL);
+    if (!compiled)
+    {
+        fprintf(stderr, "getopt_gen: out of memory\n");
+        exit(1);
+    }
+
+    fprintf(out, "/* Generated by getopt_gen from %s.  Do not edit.  */\n\n", spec);
+    fprintf(out, "#include <stdlib.h>\n\n");
+    fprintf(out, "#include \"getopt.h\"\n");
+    fprintf(out, "#include \"getopt_int.h\"\n");
+    fprintf(out, "#include \"%s\"\n\n", header);
+
+    // each flag variable once
+    for (i = 0; i < nopts; ++i)
+    {
+        int j;
+        if (!opts[i].flag)
+            continue;
+        for (j = 0; j < i && !(opts[j].flag && !strcmp(opts[j].flag, opts[i].flag)); ++j)
+            ;
+        if (j == i)
+        {
+            fprintf(out, "extern int %s;\n", opts[i].flag);
+            flags = 1;
+        }
+    }
+    if (flags)
+        fprintf(out, "\n");
+
+    fprintf(out, "const char %s_optstring[] = ", prefix);
+    put_string(out, optstring);
+    fprintf(out, ";\n\n");
+
+    fprintf(out, "const struct option %s_longopts[] =\n{\n", prefix);
+    for (i = 0; i < nopts; ++i)
+    {
+        fprintf(out, "  { ");
+        put_string(out, opts[i].name);
+        fprintf(out, ", %s, ", opts[i].has_arg == no_argument ? "no_argument"
+                : opts[i].has_arg == required_argument ? "required_argument"
+                : "optional_argument");
+        if (opts[i].flag)
+            fprintf(out, "&%s, ", opts[i].flag);
+        else
+            fprintf(out, "NULL, ");
+        put_char(out, opts[i].val);
+        fprintf(out, " },\n");
+    }
+    fprintf(out, "  { NULL, 0, NULL, 0 }\n};\n\n");
+
+    fprintf(out, "/* The long option NAME of NAMELEN characters abbreviates, as\n"
+                 "   `_getopt_longindex_find' would find it.  */\n\n");
+    fprintf(out, "static int\n%s_match (const char *name, size_t namelen, int strict,\n"
+                 "%*sint *exact, int *ambig)\n{\n", prefix, (int)strlen(prefix) + 8, "");
+    fprintf(out, "  *exact = 0;\n  *ambig = 0;\n");
+    if (nopts > 0)
+        put_node(out, opts[0].name, 0, 2);
+    else
+        fprintf(out, "  return -1;\n");
+    fprintf(out, "}\n\n");
+
+    fprintf(out, "/* Without and with POSIXLY_CORRECT in the environment.  */\n\n");
+    fprintf(out, "static const struct getopt_spec %s_specs[2] =\n{\n", prefix);
+    put_spec(out, prefix, compiled->shortopts, normal, 0, skip);
+    fprintf(out, ",\n");
+    put_spec(out, prefix, compiled->shortopts, posix, 1, skip);
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "const struct getopt_spec *\n%s_spec (void)\n{\n", prefix);
+    fprintf(out, "  static int posixly_correct = -1;\n\n");
+    fprintf(out, "  if (posixly_correct < 0)\n");
+    fprintf(out, "    posixly_correct = getenv (\"POSIXLY_CORRECT\") != NULL;\n");
+    fprintf(out, "  return &%s_specs[posixly_correct];\n}\n\n", prefix);
+
+    fprintf(out, "int\n%s_getopt_long_r (int argc, char *const *argv, int *longind,\n"
+                 "%*sstruct getopt_state *state)\n{\n", prefix, (int)strlen(prefix) + 17, "");
+    fprintf(out, "  return getopt_long_spec_r (argc, argv, %s_spec (), longind, state);\n}\n\n",
+            prefix);
+    fprintf(out, "int\n%s_getopt_long_only_r (int argc, char *const *argv, int *longind,\n"
+                 "%*sstruct getopt_state *state)\n{\n", prefix, (int)strlen(prefix) + 22, "");
+    fprintf(out, "  return getopt_long_only_spec_r (argc, argv, %s_spec (), longind,\n"
+                 "%*sstate);\n}\n", prefix, 34, "");
+
+    getopt_spec_free(compiled);
+}
+
+void write_header(FILE *out, const char *spec, const char *prefix)
+{
+    char guard[256];
+    size_t i;
+
+    for (i = 0; prefix[i] && i < sizeof(guard) - 3; ++i)
+        guard[i] = (char)toupper((unsigned char)prefix[i]);
+    strcpy(guard + i, "_H");
+
+    fprintf(out, "/* Generated by getopt_gen from %s.  Do not edit.  */\n\n", spec);
+    fprintf(out, "#ifndef %s\n#define %s 1\n\n", guard, guard);
+    fprintf(out, "#include \"getopt.h\"\n\n");
+    fprintf(out, "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n");
+    fprintf(out, "extern const char %s_optstring[];\n", prefix);
+    fprintf(out, "extern const struct option %s_longopts[];\n\n", prefix);
+    fprintf(out, "/* The compiled form of both, to pass to the `*_spec_r' functions.  */\n");
+    fprintf(out, "extern const struct getopt_spec *%s_spec (void);\n\n", prefix);
+    fprintf(out, "extern int %s_getopt_long_r (int __argc, char *const *__argv,\n"
+                 "%*sint *__longind, struct getopt_state *__state);\n",
+            prefix, (int)strlen(prefix) + 28, "");
+    fprintf(out, "extern int %s_getopt_long_only_r (int __argc, char *const *__argv,\n"
+                 "%*sint *__longind,\n%*sstruct getopt_state *__state);\n\n",
+            prefix, (int)strlen(prefix) + 33, "", (int)strlen(prefix) + 33, "");
+    fprintf(out, "#ifdef __cplusplus\n}\n#endif\n\n#endif\n");
+}
+
+int main(int argc, char **argv)
+{
+    FILE *source, *header;
+    const char *name;
+
+    if (argc != 5)
+    {
+        usage();
+        return 1;
+    }
+
+    read_spec(argv[1]);
+
+    source = fopen(argv[3], "w");
+    header = fopen(argv[4], "w");
+    if (!source || !header)
+    {
+        perror("getopt_gen");
+        return 1;
+    }
+
+    // the generated source includes the header by its file name
+    for (name = argv[4] + strlen(argv[4]); name > argv[4]; --name)
+        if (name[-1] == '/' || name[-1] == '\\')
+            break;
+    write_source(source, argv[1], argv[2], name);
+    write_header(header, argv[1], argv[2]);
+
+    if (fclose(source) || fclose(header))
+    {
+        perror("getopt_gen");
+        return 1;
+    }
+    return 0;
+}
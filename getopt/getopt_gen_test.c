@@ -0,0 +1,69 @@
+// test getopt_gen: getopt_test's options, matched by generated code
+
+#include <getopt.h>
+#include <stdio.h>
+#include <test_options.h>
+
+void usage()
+{
+    const struct option *op;
+
+    printf("usage: getopt_gen_test [-%s]", test_options_optstring);
+    for(op = test_options_longopts; op->name; ++op)
+    {
+        if(op->has_arg)
+            printf(" [--%s arg]", op->name);
+        else
+            printf(" [--%s]", op->name);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    int c;
+
+    if(argc == 1)
+    {
+        usage();
+    }
+
+    while (1)
+    {
+        int longindex = -1;
+
+        c = test_options_getopt_long_r(argc, argv, &longindex, &state);
+        if (c == -1)
+            break;
+
+        switch (c)
+        {
+            case 0:
+                printf("option %s", test_options_longopts[longindex].name);
+                if (state.optarg)
+                    printf(" with arg %s", state.optarg);
+                printf("\n");
+                break;
+
+            case '?':
+                break;
+
+            default:
+                if (state.optarg)
+                    printf("option %c with value '%s'\n", c, state.optarg);
+                else
+                    printf("option %c\n", c);
+        } // switch
+    } // while
+
+    if (state.optind < argc)
+    {
+        printf("non-option ARGV-elements: ");
+        while (state.optind < argc)
+            printf("%s ", argv[state.optind++]);
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,274 @@
+/* Precompiled long-option index for getopt.
+   This file is distributed under the same terms as getopt.c.
+
+   `_getopt_internal' matches a long option by comparing the name against
+   every element of LONGOPTS, which costs O(options * length) for every
+   argument.  A `struct getopt_longindex' is a trie over the option names,
+   built once, in which every node already knows the answer that linear
+   scan would give for a name ending there: the first option with that
+   prefix, the first option whose name is exactly that prefix, and whether
+   a further match would make an abbreviation ambiguous.  A lookup then
+   only walks the characters of the name.  */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "getopt.h"
+#include "getopt_int.h"
+
+struct longindex_node
+{
+  int first;			/* Lowest index of an option with this prefix.  */
+  int exact;			/* Lowest index of an option with exactly this
+				   name, or -1.  */
+  int child;			/* Index in `nodes' of the first child.  */
+  int nchild;			/* Children are contiguous, sorted by label.  */
+  char multi;			/* More than one option has this prefix.  */
+  char ambig;			/* Some option with this prefix is not
+				   equivalent to FIRST.  */
+};
+
+struct getopt_longindex
+{
+  struct longindex_node *nodes;
+  unsigned char *labels;	/* labels[i] is the edge leading to nodes[i].  */
+  int nnodes;
+};
+
+/* Two options are interchangeable for abbreviation purposes if they
+   would have the same effect; see the ambiguity test in getopt.c.  */
+
+static int
+equivalent_options (const struct option *a, const struct option *b)
+{
+  return (a->has_arg == b->has_arg
+	  && a->flag == b->flag
+	  && a->val == b->val);
+}
+
+/* Work items of the trie construction: the options in
+   order[lo, hi) all share the first DEPTH characters.  */
+
+struct longindex_span
+{
+  int lo, hi, depth;
+};
+
+struct longindex_entry
+{
+  const char *name;
+  int index;
+};
+
+static int
+compare_entries (const void *a, const void *b)
+{
+  const struct longindex_entry *ea = (const struct longindex_entry *) a;
+  const struct longindex_entry *eb = (const struct longindex_entry *) b;
+  int r = strcmp (ea->name, eb->name);
+  if (r != 0)
+    return r;
+  return ea->index - eb->index;
+}
+
+struct getopt_longindex *
+getopt_longindex_new (const struct option *longopts)
+{
+  struct getopt_longindex *index;
+  struct longindex_span *work;
+  struct longindex_entry *order;
+  size_t maxnodes = 1;
+  int nopts = 0;
+  int head, tail;
+  int i;
+
+  for (i = 0; longopts[i].name; i++)
+    maxnodes += strlen (longopts[i].name);
+  nopts = i;
+
+  index = (struct getopt_longindex *) malloc (sizeof *index);
+  order = (struct longindex_entry *) malloc ((nopts + 1) * sizeof *order);
+  work = (struct longindex_span *) malloc (maxnodes * sizeof *work);
+  if (index != NULL)
+    {
+      index->nodes = (struct longindex_node *)
+	malloc (maxnodes * sizeof *index->nodes);
+      index->labels = (unsigned char *) malloc (maxnodes);
+    }
+  if (index == NULL || order == NULL || work == NULL
+      || index->nodes == NULL || index->labels == NULL)
+    {
+      free (order);
+      free (work);
+      getopt_longindex_free (index);
+      return NULL;
+    }
+  /* Sorting the names puts every set of options sharing a prefix in one
+     contiguous run, with a name that is exactly the prefix first.  */
+  for (i = 0; i < nopts; i++)
+    {
+      order[i].name = longopts[i].name;
+      order[i].index = i;
+    }
+  qsort (order, nopts, sizeof *order, compare_entries);
+
+  /* Build the trie breadth first so that the children of each node are
+     allocated next to each other, in label order.  */
+  index->labels[0] = '\0';
+  work[0].lo = 0;
+  work[0].hi = nopts;
+  work[0].depth = 0;
+  head = 0;
+  tail = 1;
+  while (head < tail)
+    {
+      struct longindex_node *node = &index->nodes[head];
+      int lo = work[head].lo;
+      int hi = work[head].hi;
+      int depth = work[head].depth;
+      int j;
+
+      node->first = -1;
+      node->exact = -1;
+      node->multi = hi - lo > 1;
+      node->ambig = 0;
+      for (j = lo; j < hi; j++)
+	if (node->first < 0 || order[j].index < node->first)
+	  node->first = order[j].index;
+      for (j = lo; j < hi; j++)
+	if (!equivalent_options (&longopts[order[j].index],
+				 &longopts[node->first]))
+	  node->ambig = 1;
+
+      /* Names that end here sort first; the lowest index among them
+	 wins, as with the linear scan.  */
+      for (j = lo; j < hi && order[j].name[depth] == '\0'; j++)
+	if (node->exact < 0 || order[j].index < node->exact)
+	  node->exact = order[j].index;
+
+      node->child = tail;
+      node->nchild = 0;
+      while (j < hi)
+	{
+	  unsigned char c = (unsigned char) order[j].name[depth];
+	  int k = j;
+
+	  while (k < hi && (unsigned char) order[k].name[depth] == c)
+	    k++;
+	  index->labels[tail] = c;
+	  work[tail].lo = j;
+	  work[tail].hi = k;
+	  work[tail].depth = depth + 1;
+	  tail++;
+	  node->nchild++;
+	  j = k;
+	}
+      head++;
+    }
+  index->nnodes = tail;
+  free (order);
+  free (work);
+  return index;
+}
+
+void
+getopt_longindex_free (struct getopt_longindex *index)
+{
+  if (index == NULL)
+    return;
+  free (index->nodes);
+  free (index->labels);
+  free (index);
+}
+
+/* The node reached by the NAMELEN characters at NAME, or null.  */
+
+static const struct longindex_node *
+descend (const struct getopt_longindex *index, const char *name,
+	 size_t namelen)
+{
+  const struct longindex_node *node = &index->nodes[0];
+  size_t i;
+
+  for (i = 0; i < namelen; i++)
+    {
+      unsigned char c = (unsigned char) name[i];
+      int lo = node->child;
+      int hi = node->child + node->nchild;
+
+      while (lo < hi)
+	{
+	  int mid = lo + (hi - lo) / 2;
+	  if (index->labels[mid] < c)
+	    lo = mid + 1;
+	  else
+	    hi = mid;
+	}
+      if (lo == node->child + node->nchild || index->labels[lo] != c)
+	return NULL;
+      node = &index->nodes[lo];
+    }
+  return node;
+}
+
+int
+_getopt_longindex_find (const struct getopt_longindex *index,
+			const char *name, size_t namelen, int strict,
+			int *exact, int *ambig)
+{
+  const struct longindex_node *node = descend (index, name, namelen);
+
+  *exact = 0;
+  *ambig = 0;
+  if (node == NULL)
+    return -1;
+
+  if (node->exact >= 0)
+    {
+      *exact = 1;
+      return node->exact;
+    }
+  *ambig = strict ? node->multi : node->ambig;
+  return node->first;
+}
+
+int
+_getopt_longindex_prefixed (const struct getopt_longindex *index,
+			    const char *name, size_t namelen, int *found,
+			    int max)
+{
+  const struct longindex_node *node = descend (index, name, namelen);
+  int stackbuf[64];
+  int *stack = stackbuf;
+  int top = 0;
+  int n = 0;
+
+  if (node == NULL || max <= 0)
+    return 0;
+  if (index->nnodes > (int) (sizeof stackbuf / sizeof stackbuf[0]))
+    {
+      stack = (int *) malloc (index->nnodes * sizeof *stack);
+      if (stack == NULL)
+	return 0;
+    }
+
+  /* Depth first, the children in reverse so that the lowest label comes
+     off the stack first: a name ending at a node sorts before the names
+     below it, so the names come out sorted, and the walk stops after the
+     first MAX of them.  */
+  stack[top++] = (int) (node - index->nodes);
+  while (top > 0 && n < max)
+    {
+      int c;
+
+      node = &index->nodes[stack[--top]];
+      if (node->exact >= 0)
+	found[n++] = node->exact;
+      for (c = node->child + node->nchild - 1; c >= node->child; c--)
+	stack[top++] = c;
+    }
+
+  if (stack != stackbuf)
+    free (stack);
+  return n;
+}
@@ -0,0 +1,146 @@
+/* Internal declarations for getopt.
+   Copyright (C) 1989-1994,1996-1999,2001,2003,2004
+   Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, write to the Free
+   Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+   02111-1307 USA.  */
+
+#ifndef _GETOPT_INT_H
+#define _GETOPT_INT_H	1
+
+#include <stddef.h>
+
+/* Values of `struct getopt_state.__ordering'.  See the description of
+   the three modes in getopt.c.  */
+
+enum __getopt_ordering
+{
+  REQUIRE_ORDER, PERMUTE, RETURN_IN_ORDER
+};
+
+/* A long-option lookup with the interface of `_getopt_longindex_find',
+   without the index.  `getopt_gen' writes these, specialized for one
+   option set, into the static `struct getopt_spec' it generates.  */
+
+typedef int getopt_longmatch (const char *__name, size_t __namelen,
+			      int __strict, int *__exact, int *__ambig);
+
+/* What OPTSTRING says about one option character.  */
+
+#define SHORT_LISTED	0x01	/* The character occurs in OPTSTRING.  */
+#define SHORT_ARG	0x02	/* It is followed by `:'.  */
+#define SHORT_OPTIONAL	0x04	/* It is followed by `::'.  */
+#define SHORT_W		0x08	/* `W;': `-W foo' stands for `--foo'.  */
+
+/* The flags for the option character at TEMP, the result of looking it
+   up in OPTSTRING (or null).  */
+
+extern int _getopt_short_flags (const char *__temp);
+
+/* Whether OPTSTRING asks for `:' rather than `?' on a missing argument,
+   and for no messages: it does if it starts with `:', or with `:' after
+   the `-' or `+' that selects the ordering.  */
+
+extern int _getopt_colon_p (const char *__optstring);
+
+/* An option specification compiled by `getopt_compile'.  */
+
+struct getopt_spec
+{
+  const char *optstring;	/* Past any leading `-' or `+'.  */
+  const struct option *longopts;
+  struct getopt_longindex *longindex;	/* Null without LONGOPTS.  */
+  /* If not null, used instead of LONGINDEX; see `getopt_longmatch'.  */
+  getopt_longmatch *longmatch;
+  int ordering;			/* An `enum __getopt_ordering'.  */
+  int posixly_correct;
+  int colon;			/* OPTSTRING starts with `:'.  */
+  unsigned char shortopts[256];	/* SHORT_* flags by character.  */
+};
+
+/* The reentrant scanner behind every getopt entry point.  Same contract
+   as `_getopt_internal', with all of the state kept in D.  */
+
+extern int _getopt_internal_r (int ___argc, char *const *___argv,
+			       const char *__shortopts,
+			       const struct option *__longopts, int *__longind,
+			       int __long_only, struct getopt_state *__data);
+
+/* The same, scanning for the options compiled into SPEC.  */
+
+extern int _getopt_spec_internal_r (int ___argc, char *const *___argv,
+				    const struct getopt_spec *__spec,
+				    int *__longind, int __long_only,
+				    struct getopt_state *__data);
+
+/* The same, scanning length-delimited VIEWS rather than strings.  */
+
+extern int _getopt_view_internal_r (int ___argc,
+				    const struct getopt_view *__views,
+				    const struct getopt_spec *__spec,
+				    int *__longind, int __long_only,
+				    struct getopt_state *__data);
+
+/* Or'ed into the LONG_ONLY argument of the internal scanners by scans
+   that must not be recorded.  */
+
+#define _GETOPT_NORECORD	0x2
+
+/* Append the start of a scan with state D to the recording, if one is on;
+   OPTSTRING is past any leading `-' or `+'.  */
+
+extern void _getopt_record_scan (int ___argc, char *const *___argv,
+				 const struct getopt_view *__views,
+				 const char *__optstring,
+				 const struct option *__longopts,
+				 int __long_only,
+				 const struct getopt_state *__data);
+
+/* Collect the options of a whole scan of ARGV with state D into EVENTS,
+   for `getopt_parse_all' and the like; the result is that of
+   `getopt_parse_all'.  */
+
+extern int _getopt_parse_events (int ___argc, char *const *___argv,
+				 const struct getopt_spec *__spec, int __flags,
+				 struct getopt_event *__events,
+				 int __maxevents, struct getopt_state *__data);
+
+/* Look up the first NAMELEN characters of NAME in INDEX, with the same
+   result as the linear scan over the LONGOPTS it was built from: the index
+   of an exact match (*EXACT set), else of the first option the name
+   abbreviates, or -1.  *AMBIG is set if the abbreviation also matches
+   another option; if STRICT is zero, only one whose `has_arg', `flag' or
+   `val' differs counts.  */
+
+extern int _getopt_longindex_find (const struct getopt_longindex *__index,
+				   const char *__name, size_t __namelen,
+				   int __strict, int *__exact, int *__ambig);
+
+/* Store in FOUND the indices of up to MAX of the options whose names
+   start with the NAMELEN characters at NAME, in the order of the names and
+   one for each name, the lowest index among equal ones.  Returns how many
+   were stored.  */
+
+extern int _getopt_longindex_prefixed (const struct getopt_longindex *__index,
+				       const char *__name, size_t __namelen,
+				       int *__found, int __max);
+
+/* The name at index I of INDEX.  */
+
+extern const char *_getopt_nameindex_name (const struct getopt_nameindex *__index,
+					   int __i);
+
+#endif /* getopt_int.h */
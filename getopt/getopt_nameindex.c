@@ -0,0 +1,261 @@
+/* Nearest-name index for getopt.
+   This file is distributed under the same terms as getopt.c.
+
+   Suggesting a name for a misspelled one means finding the names within
+   a small edit distance of it, and computing the distance to every name
+   gets slow with thousands of them.  A `struct getopt_nameindex' keeps
+   the names sorted, so that names sharing a prefix are next to each other
+   and the rows of the Levenshtein table for that prefix are computed once
+   for all of them, as if walking a trie of the names.  Nothing depends on
+   what the names are, so the index serves for the names of a LONGOPTS as
+   well as for any other table of names.
+
+   A lookup for names within MAXDIST of a word only computes the cells
+   within MAXDIST of the diagonal of each row, since the others are
+   further than that, and as soon as a whole row is past MAXDIST it skips
+   every name with the prefix that row stands for.  Names whose length
+   differs from the word's by more than MAXDIST are never near enough, so
+   a word that long is not looked up at all.  */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "getopt.h"
+#include "getopt_int.h"
+
+struct nameindex_entry
+{
+  const char *str;
+  int name;			/* Index of the name.  */
+  int common;			/* Length of the prefix shared with the
+				   previous entry.  */
+};
+
+struct getopt_nameindex
+{
+  const char **names;
+  size_t *lens;
+  int nnames;
+  size_t maxlen;
+  struct nameindex_entry *sorted; /* Each name once, sorted.  */
+  int nsorted;
+};
+
+static int
+compare_entries (const void *a, const void *b)
+{
+  const struct nameindex_entry *x = (const struct nameindex_entry *) a;
+  const struct nameindex_entry *y = (const struct nameindex_entry *) b;
+  int c = strcmp (x->str, y->str);
+
+  if (c != 0)
+    return c;
+  return x->name < y->name ? -1 : x->name > y->name;
+}
+
+struct getopt_nameindex *
+getopt_nameindex_new (const char *const *names, int nnames, size_t stride)
+{
+  struct getopt_nameindex *index;
+  int i;
+
+  if (stride == 0)
+    stride = sizeof *names;
+#define NAME(i) (*(const char *const *) ((const char *) names + (i) * stride))
+  if (nnames < 0)
+    for (nnames = 0; NAME (nnames) != NULL; nnames++)
+      /* Count them.  */ ;
+
+  index = (struct getopt_nameindex *) malloc (sizeof *index);
+  if (index == NULL)
+    return NULL;
+  index->nnames = nnames;
+  index->nsorted = 0;
+  index->maxlen = 0;
+  index->names = (const char **) malloc ((nnames + 1) * sizeof *index->names);
+  index->lens = (size_t *) malloc ((nnames + 1) * sizeof *index->lens);
+  index->sorted = (struct nameindex_entry *)
+    malloc ((nnames + 1) * sizeof *index->sorted);
+  if (index->names == NULL || index->lens == NULL || index->sorted == NULL)
+    {
+      getopt_nameindex_free (index);
+      return NULL;
+    }
+  for (i = 0; i < nnames; i++)
+    {
+      index->names[i] = NAME (i);
+      index->lens[i] = strlen (index->names[i]);
+      if (index->lens[i] > index->maxlen)
+	index->maxlen = index->lens[i];
+      index->sorted[i].str = index->names[i];
+      index->sorted[i].name = i;
+    }
+#undef NAME
+
+  /* Equal names sort by index, and a name that is already there keeps
+     its first index.  */
+  qsort (index->sorted, nnames, sizeof *index->sorted, compare_entries);
+  for (i = 0; i < nnames; i++)
+    {
+      struct nameindex_entry *e = &index->sorted[i];
+      const char *prev;
+      int common = 0;
+
+      if (index->nsorted > 0)
+	{
+	  prev = index->sorted[index->nsorted - 1].str;
+	  while (prev[common] != '\0' && prev[common] == e->str[common])
+	    common++;
+	  if (prev[common] == '\0' && e->str[common] == '\0')
+	    continue;
+	}
+      e->common = common;
+      index->sorted[index->nsorted++] = *e;
+    }
+  return index;
+}
+
+void
+getopt_nameindex_free (struct getopt_nameindex *index)
+{
+  if (index == NULL)
+    return;
+  free (index->names);
+  free (index->lens);
+  free (index->sorted);
+  free (index);
+}
+
+int
+getopt_nameindex_nearest (const struct getopt_nameindex *index,
+			  const char *name, size_t namelen, int maxdist,
+			  int *nearest, int maxnearest)
+{
+  int rowbuf[1024];
+  int *rows = rowbuf;
+  int dists[GETOPT_MAX_SUGGESTIONS];
+  int *found = dists;
+  int nfound = 0;
+  size_t width = namelen + 1;
+  size_t band, valid, i, j;
+  int big, k;
+
+  if (index->nsorted == 0 || maxnearest <= 0 || maxdist < 0
+      || namelen > index->maxlen + (size_t) maxdist)
+    return 0;
+  if ((size_t) maxdist > index->maxlen + namelen)
+    maxdist = (int) (index->maxlen + namelen);
+  big = maxdist + 1;
+  band = (size_t) maxdist;
+  /* Row I is the distance from the first I characters of a name to each
+     prefix of NAME, or BIG if it is more than MAXDIST.  */
+  if ((index->maxlen + 1) * width > sizeof rowbuf / sizeof rowbuf[0])
+    rows = (int *) malloc ((index->maxlen + 1) * width * sizeof *rows);
+  if (maxnearest > GETOPT_MAX_SUGGESTIONS)
+    found = (int *) malloc (maxnearest * sizeof *found);
+  if (rows == NULL || found == NULL)
+    goto out;
+
+  for (j = 0; j < width; j++)
+    rows[j] = j <= band ? (int) j : big;
+  valid = 0;
+
+  for (k = 0; k < index->nsorted; k++)
+    {
+      const struct nameindex_entry *e = &index->sorted[k];
+      size_t len = index->lens[e->name];
+      int d;
+
+      /* The rows for the prefix shared with the previous name are still
+	 there.  */
+      i = valid < (size_t) e->common ? valid : (size_t) e->common;
+      for (i++; i <= len; i++)
+	{
+	  const int *prev = &rows[(i - 1) * width];
+	  int *cur = &rows[i * width];
+	  size_t lo = i > band ? i - band : 0;
+	  size_t hi = i + band < namelen ? i + band : namelen;
+	  int rowmin = big;
+
+	  if (lo > namelen)
+	    break;
+	  if (lo > 0)
+	    cur[lo - 1] = big;
+	  else
+	    {
+	      cur[0] = i <= band ? (int) i : big;
+	      rowmin = cur[0];
+	      lo = 1;
+	    }
+	  for (j = lo; j <= hi; j++)
+	    {
+	      int best = prev[j - 1] + (e->str[i - 1] != name[j - 1]);
+
+	      if (prev[j] + 1 < best)
+		best = prev[j] + 1;
+	      if (cur[j - 1] + 1 < best)
+		best = cur[j - 1] + 1;
+	      if (best > big)
+		best = big;
+	      cur[j] = best;
+	      if (best < rowmin)
+		rowmin = best;
+	    }
+	  if (hi < namelen)
+	    cur[hi + 1] = big;
+	  /* Every way on goes through this row.  */
+	  if (rowmin > maxdist)
+	    break;
+	}
+      if (i <= len)
+	{
+	  /* Nor can any other name starting with these I characters be
+	     near enough.  */
+	  valid = i - 1;
+	  while (k + 1 < index->nsorted
+		 && (size_t) index->sorted[k + 1].common >= i)
+	    k++;
+	  continue;
+	}
+      valid = len;
+      if ((len > namelen ? len - namelen : namelen - len) > band)
+	continue;
+      d = rows[len * width + namelen];
+      if (d > maxdist)
+	continue;
+
+      {
+	/* Insert by distance, then by index of the name.  */
+	int n = nfound < maxnearest ? nfound++ : maxnearest;
+
+	while (n > 0 && (found[n - 1] > d
+			 || (found[n - 1] == d && nearest[n - 1] > e->name)))
+	  {
+	    if (n < maxnearest)
+	      {
+		found[n] = found[n - 1];
+		nearest[n] = nearest[n - 1];
+	      }
+	    n--;
+	  }
+	if (n < maxnearest)
+	  {
+	    found[n] = d;
+	    nearest[n] = e->name;
+	  }
+      }
+    }
+
+ out:
+  if (rows != rowbuf)
+    free (rows);
+  if (found != dists)
+    free (found);
+  return nfound;
+}
+
+const char *
+_getopt_nameindex_name (const struct getopt_nameindex *index, int i)
+{
+  return index->names[i];
+}
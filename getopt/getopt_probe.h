@@ -0,0 +1,50 @@
+/* Static probes in the parsers.
+   This file is distributed under the same terms as getopt.c.
+
+   Where <sys/sdt.h> is found at configuration time (HAVE_SYS_SDT_H),
+   each probe is a `nop' and a note that tools such as perf, bpftrace and
+   SystemTap find in the library and turn into a breakpoint when asked
+   to, as USDT probes `getopt:NAME' and `moduleparam:NAME'.  A probe that
+   is not being traced costs that one instruction and keeping its
+   arguments at hand, so arguments should be values already computed.
+   Elsewhere, or with GETOPT_NO_PROBES defined, the probes are nothing.
+
+   getopt:option__entry (argc, optind)
+   getopt:option__return (result, optind)
+					one call of a scan for an option
+   getopt:long__match (name, namelen, index, exact)
+   getopt:long__ambiguous (name, namelen)
+   getopt:exchange (first_nonopt, nonopts, opts)
+					the segments ARGV is permuted by,
+					also when the runs of non-options
+					left in place are moved at once
+   moduleparam:parse_args__entry (num, argc)
+   moduleparam:parse_args__return (result)
+   moduleparam:param_set__entry (name, val)
+   moduleparam:param_set_view__entry (name, val, vallen)
+					VAL is not NUL-terminated, from
+					parse_args_buf and the file loaders
+   moduleparam:param_set__return (name, result)  */
+
+#ifndef _GETOPT_PROBE_H
+#define _GETOPT_PROBE_H	1
+
+#if defined HAVE_SYS_SDT_H && !defined GETOPT_NO_PROBES
+# include <sys/sdt.h>
+# define GETOPT_PROBE0(provider, name) DTRACE_PROBE (provider, name)
+# define GETOPT_PROBE1(provider, name, a1) DTRACE_PROBE1 (provider, name, a1)
+# define GETOPT_PROBE2(provider, name, a1, a2) \
+  DTRACE_PROBE2 (provider, name, a1, a2)
+# define GETOPT_PROBE3(provider, name, a1, a2, a3) \
+  DTRACE_PROBE3 (provider, name, a1, a2, a3)
+# define GETOPT_PROBE4(provider, name, a1, a2, a3, a4) \
+  DTRACE_PROBE4 (provider, name, a1, a2, a3, a4)
+#else
+# define GETOPT_PROBE0(provider, name) ((void) 0)
+# define GETOPT_PROBE1(provider, name, a1) ((void) 0)
+# define GETOPT_PROBE2(provider, name, a1, a2) ((void) 0)
+# define GETOPT_PROBE3(provider, name, a1, a2, a3) ((void) 0)
+# define GETOPT_PROBE4(provider, name, a1, a2, a3, a4) ((void) 0)
+#endif
+
+#endif /* getopt_probe.h */
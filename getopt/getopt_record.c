@@ -0,0 +1,459 @@
+/* Recording of scans for getopt.
+   This file is distributed under the same terms as getopt.c.
+
+   While a recording is on, every scan appends the command line it was
+   started on to a log, for `getopt_replay' to run again offline.  The log
+   is a file of fixed capacity mapped into memory and shared by all
+   threads: a writer reserves the bytes of its record with one atomic
+   addition to the end offset, fills them in without any lock, and marks
+   the record complete last.  When no recording is on, a scan pays for one
+   atomic load.
+
+   Writers count themselves in `writers' before they look for the
+   recorder, and out once their record is complete.  Stopping clears the
+   recorder first and only unmaps the log once the count has come down to
+   zero, so no writer is left holding a pointer into it.
+
+   The log starts with GETOPT_RECORD_MAGIC and is followed by records,
+   each a `struct record_header' and a payload, padded to 8 bytes.  A
+   record that is not marked complete when the log is read is skipped,
+   and a header of size zero ends the log.  Numbers are stored in the
+   byte order of the machine.  */
+
+#ifdef WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sched.h>
+# include <sys/mman.h>
+# include <time.h>
+# include <unistd.h>
+#endif
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "getopt.h"
+#include "getopt_int.h"
+
+/* The recorder pointer and the count of writers are accessed
+   sequentially consistently: a writer that finds the recorder must be
+   seen in the count by the stop that clears it.  */
+#ifdef WIN32
+# define atomic_load_ptr(p)	InterlockedCompareExchangePointer ((PVOID volatile *) (p), NULL, NULL)
+# define atomic_store_ptr(p, v)	InterlockedExchangePointer ((PVOID volatile *) (p), (v))
+# define atomic_cas_ptr(p, o, n) \
+  (InterlockedCompareExchangePointer ((PVOID volatile *) (p), (n), (o)) == (o))
+# define atomic_load64(p)	InterlockedCompareExchange64 ((LONGLONG volatile *) (p), 0, 0)
+# define atomic_cas64(p, o, n) \
+  (InterlockedCompareExchange64 ((LONGLONG volatile *) (p), (n), (o)) == (LONGLONG) (o))
+# define atomic_add(p, n)	InterlockedExchangeAdd64 ((LONGLONG volatile *) (p), (n))
+# define atomic_store16(p, v)	InterlockedExchange16 ((SHORT volatile *) (p), (v))
+# define atomic_enter(p)	InterlockedIncrement ((LONG volatile *) (p))
+# define atomic_leave(p)	InterlockedDecrement ((LONG volatile *) (p))
+# define atomic_count(p)	InterlockedCompareExchange ((LONG volatile *) (p), 0, 0)
+# define yield()		SwitchToThread ()
+#else
+# define atomic_load_ptr(p)	__atomic_load_n ((p), __ATOMIC_SEQ_CST)
+# define atomic_store_ptr(p, v)	__atomic_exchange_n ((p), (v), __ATOMIC_SEQ_CST)
+# define atomic_cas_ptr(p, o, n) \
+  __atomic_compare_exchange_n ((p), &(o), (n), 0, __ATOMIC_ACQ_REL,	      \
+			       __ATOMIC_ACQUIRE)
+# define atomic_load64(p)	__atomic_load_n ((p), __ATOMIC_ACQUIRE)
+# define atomic_cas64(p, o, n) \
+  __atomic_compare_exchange_n ((p), &(o), (n), 0, __ATOMIC_ACQ_REL,	      \
+			       __ATOMIC_ACQUIRE)
+# define atomic_add(p, n)	__atomic_fetch_add ((p), (n), __ATOMIC_RELAXED)
+# define atomic_store16(p, v)	__atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+# define atomic_enter(p)	__atomic_fetch_add ((p), 1, __ATOMIC_SEQ_CST)
+# define atomic_leave(p)	__atomic_fetch_sub ((p), 1, __ATOMIC_RELEASE)
+# define atomic_count(p)	__atomic_load_n ((p), __ATOMIC_SEQ_CST)
+# define yield()		sched_yield ()
+#endif
+
+/* Tables already written to the log.  Past this many, a table is written
+   again with every scan that uses it.  */
+#define RECORD_SEEN	1024
+
+struct record_header
+{
+  uint32_t size;		/* Of the whole record, padded.  */
+  uint16_t type;		/* A GETOPT_RECORD_* type.  */
+  uint16_t complete;
+  uint64_t time;		/* Nanoseconds since the epoch.  */
+};
+
+struct recorder
+{
+  char *base;
+  long long capacity;
+  long long offset;		/* Bytes reserved so far.  */
+  long long dropped;		/* Records that did not fit.  */
+  uint64_t seen[RECORD_SEEN];	/* Fingerprints of the tables written.  */
+#ifdef WIN32
+  HANDLE file;
+#else
+  int fd;
+#endif
+};
+
+static struct recorder *recording;
+static long writers;		/* Between looking for `recording' and done.  */
+
+static uint64_t
+record_time (void)
+{
+#ifdef WIN32
+  FILETIME ft;
+  ULARGE_INTEGER t;
+
+  GetSystemTimeAsFileTime (&ft);
+  t.LowPart = ft.dwLowDateTime;
+  t.HighPart = ft.dwHighDateTime;
+  /* From 100ns units since 1601.  */
+  return (t.QuadPart - 116444736000000000ull) * 100;
+#else
+  struct timespec ts;
+
+  clock_gettime (CLOCK_REALTIME, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+}
+
+/* Give back the resources of R, writing the log out at its final size.  */
+
+static void
+recorder_close (struct recorder *r)
+{
+  long long size = r->offset < r->capacity ? r->offset : r->capacity;
+
+#ifdef WIN32
+  LARGE_INTEGER end;
+
+  if (r->base != NULL)
+    UnmapViewOfFile (r->base);
+  end.QuadPart = size;
+  SetFilePointerEx (r->file, end, NULL, FILE_BEGIN);
+  SetEndOfFile (r->file);
+  CloseHandle (r->file);
+#else
+  if (r->base != NULL)
+    munmap (r->base, (size_t) r->capacity);
+  /* Should this fail, the rest of the log is zeros and reads the same.  */
+  if (ftruncate (r->fd, (off_t) size) < 0)
+    {
+    }
+  close (r->fd);
+#endif
+  free (r);
+}
+
+int
+getopt_record_start (const char *path, size_t capacity)
+{
+  struct recorder *r;
+  struct recorder *none = NULL;
+
+  if (capacity < sizeof GETOPT_RECORD_MAGIC + sizeof (struct record_header))
+    return EINVAL;
+  r = (struct recorder *) calloc (1, sizeof *r);
+  if (r == NULL)
+    return ENOMEM;
+  r->capacity = (long long) capacity;
+
+#ifdef WIN32
+  {
+    HANDLE mapping;
+    LARGE_INTEGER size;
+
+    r->file = CreateFileA (path, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+			   CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (r->file == INVALID_HANDLE_VALUE)
+      {
+	free (r);
+	return EACCES;
+      }
+    size.QuadPart = (LONGLONG) capacity;
+    mapping = CreateFileMappingA (r->file, NULL, PAGE_READWRITE,
+				  size.HighPart, size.LowPart, NULL);
+    if (mapping != NULL)
+      {
+	r->base = (char *) MapViewOfFile (mapping, FILE_MAP_WRITE, 0, 0, 0);
+	CloseHandle (mapping);
+      }
+    if (r->base == NULL)
+      {
+	recorder_close (r);
+	return ENOMEM;
+      }
+  }
+#else
+  {
+    void *p;
+
+    r->fd = open (path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (r->fd < 0)
+      {
+	int err = errno;
+	free (r);
+	return err;
+      }
+    if (ftruncate (r->fd, (off_t) capacity) < 0)
+      {
+	int err = errno;
+	recorder_close (r);
+	return err;
+      }
+    p = mmap (NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, 0);
+    if (p == MAP_FAILED)
+      {
+	int err = errno;
+	recorder_close (r);
+	return err;
+      }
+    r->base = (char *) p;
+  }
+#endif
+
+  memcpy (r->base, GETOPT_RECORD_MAGIC, sizeof GETOPT_RECORD_MAGIC);
+  r->offset = sizeof GETOPT_RECORD_MAGIC;
+  if (!atomic_cas_ptr (&recording, none, r))
+    {
+      recorder_close (r);
+      return EBUSY;
+    }
+  return 0;
+}
+
+int
+getopt_record_stop (unsigned long long *dropped)
+{
+  struct recorder *r
+    = (struct recorder *) atomic_store_ptr (&recording, (struct recorder *) NULL);
+
+  if (r == NULL)
+    return EINVAL;
+  /* New writers find no recorder now; wait for those that found it.  */
+  while (atomic_count (&writers) != 0)
+    yield ();
+  if (dropped != NULL)
+    *dropped = (unsigned long long) r->dropped;
+  recorder_close (r);
+  return 0;
+}
+
+int
+getopt_recording (void)
+{
+  return atomic_load_ptr (&recording) != NULL;
+}
+
+void *
+getopt_record_begin (int type, size_t len)
+{
+  struct recorder *r;
+  struct record_header *h;
+  long long size;
+  long long off;
+
+  atomic_enter (&writers);
+  r = (struct recorder *) atomic_load_ptr (&recording);
+  if (r == NULL)
+    {
+      atomic_leave (&writers);
+      return NULL;
+    }
+  size = (long long) ((sizeof *h + len + 7) & ~(size_t) 7);
+  if (size > r->capacity)
+    {
+      atomic_add (&r->dropped, 1);
+      atomic_leave (&writers);
+      return NULL;
+    }
+  off = atomic_add (&r->offset, size);
+  if (off + size > r->capacity)
+    {
+      atomic_add (&r->dropped, 1);
+      atomic_leave (&writers);
+      return NULL;
+    }
+
+  h = (struct record_header *) (r->base + off);
+  h->type = (uint16_t) type;
+  h->time = record_time ();
+  h->size = (uint32_t) size;
+  return h + 1;
+}
+
+void
+getopt_record_end (void *payload)
+{
+  struct record_header *h = (struct record_header *) payload - 1;
+
+  atomic_store16 (&h->complete, 1);
+  atomic_leave (&writers);
+}
+
+unsigned long long
+getopt_record_hash (unsigned long long h, const void *p, size_t len)
+{
+  const unsigned char *s = (const unsigned char *) p;
+
+  /* FNV-1a.  */
+  if (h == 0)
+    h = 14695981039346656037ull;
+  while (len--)
+    h = (h ^ *s++) * 1099511628211ull;
+  return h;
+}
+
+int
+getopt_record_once (const void *key, unsigned long long hash)
+{
+  struct recorder *r;
+  uint64_t fp;
+  size_t h;
+  int i, once = 1;
+
+  /* The address and the contents together, so that a table freed and
+     another allocated in its place is written again.  Zero marks a free
+     slot.  */
+  fp = getopt_record_hash (hash, &key, sizeof key);
+  if (fp == 0)
+    fp = 1;
+  atomic_enter (&writers);
+  r = (struct recorder *) atomic_load_ptr (&recording);
+  if (r == NULL)
+    once = 0;
+  else
+    for (h = (size_t) fp, i = 0; i < RECORD_SEEN; i++)
+      {
+	uint64_t *slot = &r->seen[(h + i) % RECORD_SEEN];
+	uint64_t old = 0;
+
+	if (atomic_cas64 (slot, old, fp))
+	  break;
+	if (atomic_load64 (slot) == fp)
+	  {
+	    once = 0;
+	    break;
+	  }
+      }
+  atomic_leave (&writers);
+  return once;
+}
+
+/* Copy LEN bytes from SRC to P and return the end of them.  */
+
+static char *
+put (char *p, const void *src, size_t len)
+{
+  memcpy (p, src, len);
+  return p + len;
+}
+
+static char *
+put16 (char *p, unsigned v)
+{
+  uint16_t x = (uint16_t) v;
+  return put (p, &x, sizeof x);
+}
+
+static char *
+put32 (char *p, unsigned long v)
+{
+  uint32_t x = (uint32_t) v;
+  return put (p, &x, sizeof x);
+}
+
+static char *
+put64 (char *p, const void *v)
+{
+  uint64_t x = (uint64_t) (uintptr_t) v;
+  return put (p, &x, sizeof x);
+}
+
+/* Write LONGOPTS to the log, unless it is there already.  */
+
+static void
+record_options (const struct option *longopts)
+{
+  const struct option *o;
+  unsigned long long hash = 0;
+  size_t len = 12;
+  char *p, *payload;
+  int n = 0;
+
+  /* What is written of each option, and so what replay can tell apart.  */
+  for (o = longopts; o->name != NULL; o++, n++)
+    {
+      size_t namelen = strlen (o->name);
+      int a[3];
+
+      a[0] = o->has_arg;
+      a[1] = o->flag != NULL;
+      a[2] = o->val;
+      hash = getopt_record_hash (hash, a, sizeof a);
+      hash = getopt_record_hash (hash, o->name, namelen + 1);
+      len += 8 + namelen;
+    }
+  if (!getopt_record_once (longopts, hash))
+    return;
+  payload = p = (char *) getopt_record_begin (GETOPT_RECORD_OPTIONS, len);
+  if (payload == NULL)
+    return;
+  p = put64 (p, longopts);
+  p = put32 (p, n);
+  for (o = longopts; o->name != NULL; o++)
+    {
+      size_t namelen = strlen (o->name);
+
+      *p++ = (char) o->has_arg;
+      *p++ = o->flag != NULL;
+      p = put16 (p, (unsigned) namelen);
+      p = put32 (p, (unsigned long) o->val);
+      p = put (p, o->name, namelen);
+    }
+  getopt_record_end (payload);
+}
+
+void
+_getopt_record_scan (int argc, char *const *argv,
+		     const struct getopt_view *views, const char *optstring,
+		     const struct option *longopts, int long_only,
+		     const struct getopt_state *d)
+{
+  size_t optlen = strlen (optstring);
+  size_t len = 20 + optlen;
+  char *p, *payload;
+  int i;
+
+  if (longopts != NULL)
+    record_options (longopts);
+
+  for (i = 0; i < argc; i++)
+    len += 4 + (views != NULL ? views[i].len : strlen (argv[i]));
+  payload = p = (char *) getopt_record_begin (GETOPT_RECORD_SCAN, len);
+  if (payload == NULL)
+    return;
+  p = put64 (p, longopts);
+  p = put16 (p, (long_only ? GETOPT_RECORD_LONG_ONLY : 0)
+	     | (d->__ordering == REQUIRE_ORDER ? GETOPT_RECORD_REQUIRE_ORDER
+		: d->__ordering == RETURN_IN_ORDER ? GETOPT_RECORD_RETURN_IN_ORDER
+		: 0)
+	     | (views != NULL ? GETOPT_RECORD_VIEWS : 0));
+  p = put16 (p, (unsigned) optlen);
+  p = put32 (p, (unsigned long) d->optind);
+  p = put32 (p, (unsigned long) argc);
+  p = put (p, optstring, optlen);
+  for (i = 0; i < argc; i++)
+    {
+      const char *arg = views != NULL ? views[i].ptr : argv[i];
+      size_t arglen = views != NULL ? views[i].len : strlen (arg);
+
+      p = put32 (p, (unsigned long) arglen);
+      p = put (p, arg, arglen);
+    }
+  getopt_record_end (payload);
+}
@@ -0,0 +1,607 @@
+// replay a recording of command lines offline and time every scan
+//
+// a program records what it parses with getopt_record_start; this loads
+// the log, rebuilds the options and parameter tables it names, and runs
+// every scan and parse_args call again, --rounds times over.  A call that
+// is quicker than the clock can tell apart is timed over a batch of
+// repetitions, and its latency is the batch time divided among them.
+
+#include <getopt.h>
+#include <moduleparam.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+# include <windows.h>
+#endif
+
+struct table
+{
+    uint64_t id;
+    struct option *options;     // for GETOPT_RECORD_OPTIONS
+    struct param_info *params;  // for GETOPT_RECORD_PARAMS
+    int n;
+};
+
+struct call
+{
+    int type;
+    struct table *table;
+    int flags;
+    char *optstring;            // with the ordering put back in front
+    struct getopt_spec *spec;   // for views
+    int optind;
+    int argc;
+    char **argv;
+    struct getopt_view *views;
+    int parse_flags;            // PARSE_ARGS_RECORD_*
+    char *line;                 // parse_args_string cuts this copy up
+};
+
+static struct table *tables;
+static int ntables, maxtables;
+static struct call *calls;
+static int ncalls, maxcalls;
+static int flag_sink;
+
+static const char *sample_argv[][8] =
+{
+    {"prog", "-a", "value", "-b", "operand", "--verbose=3", 0},
+    {"prog", "--add", "x", "--append", "--delete", "y", "-c", 0},
+    {"prog", "--app", "-cfoo", "--", "-a", 0},
+    {"prog", "--nosuch", "-z", "--add", 0},
+};
+
+static struct option sample_options[] =
+{
+    {"add", required_argument, 0, 'a'},
+    {"append", no_argument, &flag_sink, 1},
+    {"delete", required_argument, 0, 0},
+    {"verbose", optional_argument, 0, 0},
+    {0, 0, 0, 0}
+};
+
+static int sample_count, sample_on;
+static char sample_name[32] = "default";
+static int sample_array[4];
+static unsigned int sample_num;
+
+void usage(void)
+{
+    printf("usage: getopt_replay [--rounds N] [--quiet] LOG\n");
+    printf("       getopt_replay --sample LOG\n");
+    printf("--sample records a few command lines to LOG to try it on\n");
+}
+
+// a monotonic clock: the wall clock can step, and is coarse on some hosts
+double now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER t, f;
+    QueryPerformanceCounter(&t);
+    QueryPerformanceFrequency(&f);
+    return (double)t.QuadPart / f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+// the least time of a batch, many ticks of any clock
+#define MIN_BATCH 20e-6
+
+// record the sample command lines, each scanned the usual way
+int sample(const char *path)
+{
+    init_module_param(4);
+    module_param(sample_count, int);
+    module_param_bool(sample_on);
+    module_param_string(sample_name, sample_name, sizeof(sample_name));
+    module_param_array(sample_array, int, &sample_num);
+    char *params[] = {"prog", "sample_count=3", "sample_on",
+                      "sample_name=\"a b\"", "sample_array=1,2,3", 0};
+    unsigned long long dropped;
+    size_t i;
+    int err = getopt_record_start(path, 1 << 20);
+
+    if (err)
+    {
+        fprintf(stderr, "getopt_replay: %s: %s\n", path, strerror(err));
+        return 1;
+    }
+    for (i = 0; i < sizeof(sample_argv) / sizeof(sample_argv[0]); i++)
+    {
+        struct getopt_state state = GETOPT_STATE_INITIALIZER;
+        char *argv[8];
+        int argc = 0;
+
+        while (sample_argv[i][argc])
+        {
+            argv[argc] = (char *)sample_argv[i][argc];
+            argc++;
+        }
+        argv[argc] = 0;
+        state.opterr = 0;
+        while (getopt_long_r(argc, argv, "a:bc::", sample_options, 0,
+                             &state) != -1)
+            ;
+    }
+    char line[] = "sample_count=4 \"sample_name=c d\" sample_array=5";
+
+    parse_params(5, params, NULL);
+    parse_args_string(MODULE_INIT_VARIABLE, MODULE_INIT_VARIABLE_NUM, line,
+                      NULL);
+    parse_args_buf(MODULE_INIT_VARIABLE, MODULE_INIT_VARIABLE_NUM,
+                   "sample_on=n sample_array=7,8", 28, NULL);
+    getopt_record_stop(&dropped);
+    printf("recorded %zu scans and 3 parse_args to %s\n", i, path);
+    return 0;
+}
+
+static uint64_t get(const char **p, size_t size)
+{
+    uint64_t v = 0;
+
+    if (size == 2)
+    {
+        uint16_t x;
+        memcpy(&x, *p, 2);
+        v = x;
+    }
+    else if (size == 4)
+    {
+        uint32_t x;
+        memcpy(&x, *p, 4);
+        v = x;
+    }
+    else
+        memcpy(&v, *p, 8);
+    *p += size;
+    return v;
+}
+
+static char *copy(const char **p, size_t len)
+{
+    char *s = malloc(len + 1);
+
+    memcpy(s, *p, len);
+    s[len] = '\0';
+    *p += len;
+    return s;
+}
+
+static struct table *find(uint64_t id)
+{
+    int i;
+
+    // the latest table with this address wins: it may have been reused
+    for (i = ntables - 1; i >= 0; i--)
+        if (tables[i].id == id)
+            return &tables[i];
+    return NULL;
+}
+
+static struct table *add_table(uint64_t id, int n)
+{
+    struct table *t;
+
+    if (ntables == maxtables)
+    {
+        maxtables = maxtables ? 2 * maxtables : 16;
+        tables = realloc(tables, maxtables * sizeof(*tables));
+    }
+    t = &tables[ntables++];
+    memset(t, 0, sizeof(*t));
+    t->id = id;
+    t->n = n;
+    return t;
+}
+
+static struct call *add_call(int type)
+{
+    struct call *c;
+
+    if (ncalls == maxcalls)
+    {
+        maxcalls = maxcalls ? 2 * maxcalls : 256;
+        calls = realloc(calls, maxcalls * sizeof(*calls));
+    }
+    c = &calls[ncalls++];
+    memset(c, 0, sizeof(*c));
+    c->type = type;
+    return c;
+}
+
+static void read_args(const char **p, struct call *c)
+{
+    int i;
+
+    c->argv = calloc(c->argc + 1, sizeof(char *));
+    for (i = 0; i < c->argc; i++)
+    {
+        size_t len = get(p, 4);
+        c->argv[i] = copy(p, len);
+    }
+}
+
+static void load_options(const char *p)
+{
+    uint64_t id = get(&p, 8);
+    int i, n = (int)get(&p, 4);
+    struct table *t = add_table(id, n);
+
+    t->options = calloc(n + 1, sizeof(struct option));
+    for (i = 0; i < n; i++)
+    {
+        struct option *o = &t->options[i];
+        int hasflag;
+
+        o->has_arg = (unsigned char)*p++;
+        hasflag = *p++;
+        size_t namelen = get(&p, 2);
+        o->val = (int)get(&p, 4);
+        o->flag = hasflag ? &flag_sink : NULL;
+        o->name = copy(&p, namelen);
+    }
+}
+
+static int accept_any(const char *val, struct param_info *kp)
+{
+    return 0;
+}
+
+static int unknown_any(char *param, char *val)
+{
+    return 0;
+}
+
+static int unknown_any_view(const char *param, size_t len, const char *val,
+                            size_t vallen)
+{
+    return 0;
+}
+
+// give every parameter room of its own to be set in
+static void load_params(const char *p)
+{
+    uint64_t id = get(&p, 8);
+    int i, n = (int)get(&p, 4);
+    struct table *t = add_table(id, n);
+
+    t->params = calloc(n, sizeof(struct param_info));
+    for (i = 0; i < n; i++)
+    {
+        struct param_info *kp = &t->params[i];
+        int kind = (int)get(&p, 2);
+        unsigned int max, size;
+
+        kp->flags = (uint16_t)get(&p, 2);
+        max = (unsigned int)get(&p, 4);
+        size = (unsigned int)get(&p, 4);
+        kp->name = copy(&p, get(&p, 2));
+        if (kind & PARAM_KIND_ARRAY)
+        {
+            struct param_array *arr = calloc(1, sizeof(*arr));
+            arr->max = max;
+            arr->num = calloc(1, sizeof(unsigned int));
+            arr->set = param_kind_set(kind & ~PARAM_KIND_ARRAY);
+            if (!arr->set)
+                arr->set = accept_any;
+            arr->elemsize = size;
+            arr->elem = calloc(max ? max : 1, size ? size : 1);
+            kp->set = param_array_set;
+            kp->arr = arr;
+        }
+        else if (kind == PARAM_KIND_COPYSTRING)
+        {
+            struct param_string *str = calloc(1, sizeof(*str));
+            str->maxlen = max;
+            str->string = calloc(max ? max : 1, 1);
+            kp->set = param_set_copystring;
+            kp->str = str;
+        }
+        else
+        {
+            kp->set = param_kind_set(kind);
+            if (!kp->set)
+                kp->set = accept_any;
+            kp->arg = calloc(1, sizeof(long));
+        }
+    }
+}
+
+static void load_scan(const char *p)
+{
+    struct call *c = add_call(GETOPT_RECORD_SCAN);
+    uint64_t id = get(&p, 8);
+    size_t optlen;
+    int i;
+
+    c->flags = (int)get(&p, 2);
+    optlen = get(&p, 2);
+    c->optind = (int)get(&p, 4);
+    c->argc = (int)get(&p, 4);
+    c->table = id ? find(id) : NULL;
+    c->optstring = malloc(optlen + 2);
+    c->optstring[0] = c->flags & GETOPT_RECORD_REQUIRE_ORDER ? '+'
+        : c->flags & GETOPT_RECORD_RETURN_IN_ORDER ? '-' : 0;
+    memcpy(c->optstring + !!c->optstring[0], p, optlen);
+    c->optstring[optlen + !!c->optstring[0]] = '\0';
+    p += optlen;
+    read_args(&p, c);
+    if (c->flags & GETOPT_RECORD_VIEWS)
+    {
+        c->spec = getopt_compile(c->optstring,
+                                 c->table ? c->table->options : NULL);
+        c->views = calloc(c->argc + 1, sizeof(struct getopt_view));
+        for (i = 0; i < c->argc; i++)
+        {
+            c->views[i].ptr = c->argv[i];
+            c->views[i].len = strlen(c->argv[i]);
+        }
+    }
+}
+
+static void load_parse_args(const char *p)
+{
+    struct call *c = add_call(GETOPT_RECORD_PARSE_ARGS);
+
+    c->table = find(get(&p, 8));
+    c->optind = (int)get(&p, 4);   // the number of params
+    c->parse_flags = (int)get(&p, 4);
+    c->argc = (int)get(&p, 4);
+    read_args(&p, c);
+    if (c->parse_flags & PARSE_ARGS_RECORD_STRING && c->argc == 1)
+        c->line = malloc(strlen(c->argv[0]) + 1);
+}
+
+// returns the number of records skipped, or -1 if PATH is not a log
+long load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    char *log;
+    long size, off = 8, skipped = 0;
+
+    if (!f)
+        return -1;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    log = malloc(size + 1);
+    if (size < 8 || fread(log, 1, size, f) != (size_t)size
+        || memcmp(log, GETOPT_RECORD_MAGIC, 8) != 0)
+    {
+        fclose(f);
+        free(log);
+        return -1;
+    }
+    fclose(f);
+
+    while (off + 16 <= size)
+    {
+        const char *h = log + off;
+        uint32_t recsize;
+        uint16_t type, complete;
+
+        memcpy(&recsize, h, 4);
+        memcpy(&type, h + 4, 2);
+        memcpy(&complete, h + 6, 2);
+        if (recsize == 0 || off + recsize > size)
+            break;
+        off += recsize;
+        if (!complete)
+        {
+            skipped++;
+            continue;
+        }
+        if (type == GETOPT_RECORD_OPTIONS)
+            load_options(h + 16);
+        else if (type == GETOPT_RECORD_SCAN)
+            load_scan(h + 16);
+        else if (type == GETOPT_RECORD_PARAMS)
+            load_params(h + 16);
+        else if (type == GETOPT_RECORD_PARSE_ARGS)
+            load_parse_args(h + 16);
+        else
+            skipped++;
+    }
+    free(log);
+    return skipped;
+}
+
+// run C once; returns nonzero if it cannot be replayed
+static int replay(struct call *c, char **scratch)
+{
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    int longind;
+
+    if (c->type == GETOPT_RECORD_PARSE_ARGS)
+    {
+        int (*unknown)(char *, char *) =
+            c->parse_flags & PARSE_ARGS_RECORD_UNKNOWN ? unknown_any : NULL;
+
+        if (!c->table || !c->table->params)
+            return 1;
+        if (c->parse_flags & PARSE_ARGS_RECORD_BUF && c->argc == 1)
+            parse_args_buf(c->table->params, c->table->n, c->argv[0],
+                           strlen(c->argv[0]),
+                           unknown ? unknown_any_view : NULL);
+        else if (c->line)
+        {
+            strcpy(c->line, c->argv[0]);
+            parse_args_string(c->table->params, c->table->n, c->line,
+                              unknown);
+        }
+        else
+            parse_args(c->table->params, c->table->n, c->argc, c->argv,
+                       unknown);
+        return 0;
+    }
+
+    state.opterr = 0;
+    state.optind = c->optind;
+    if (c->spec)
+    {
+        if (c->flags & GETOPT_RECORD_LONG_ONLY)
+            while (getopt_long_only_view_r(c->argc, c->views, c->spec,
+                                           &longind, &state) != -1)
+                ;
+        else
+            while (getopt_long_view_r(c->argc, c->views, c->spec, &longind,
+                                      &state) != -1)
+                ;
+        return 0;
+    }
+
+    // the scan permutes its argv, so it gets a fresh copy every time
+    memcpy(scratch, c->argv, (c->argc + 1) * sizeof(char *));
+    if (c->flags & GETOPT_RECORD_LONG_ONLY)
+        while (getopt_long_only_r(c->argc, scratch, c->optstring,
+                                  c->table ? c->table->options : NULL,
+                                  &longind, &state) != -1)
+            ;
+    else
+        while (getopt_long_r(c->argc, scratch, c->optstring,
+                             c->table ? c->table->options : NULL, &longind,
+                             &state) != -1)
+            ;
+    return 0;
+}
+
+// the seconds REPS replays of C take, or -1 if it cannot be replayed
+double time_call(struct call *c, char **scratch, long reps)
+{
+    double t = now();
+    long k;
+
+    for (k = 0; k < reps; k++)
+        if (replay(c, scratch))
+            return -1;
+    return now() - t;
+}
+
+static int compare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+void report(const char *what, double *lat, long n, long nargs)
+{
+    static const double points[] = {50, 90, 99, 99.9};
+    double total = 0;
+    long i;
+
+    if (n == 0)
+        return;
+    for (i = 0; i < n; i++)
+        total += lat[i];
+    qsort(lat, n, sizeof(double), compare);
+    printf("%-10s %9ld calls %10.0f calls/s %12.0f args/s\n", what, n,
+           n / total, nargs / total);
+    printf("%-10s", "");
+    for (i = 0; i < 4; i++)
+        printf(" p%g %.0fns", points[i],
+               lat[(long)(points[i] / 100 * (n - 1))] * 1e9);
+    printf(" max %.0fns\n", lat[n - 1] * 1e9);
+}
+
+int main(int argc, char **argv)
+{
+    long rounds = 100, skipped, unreplayed = 0;
+    int quiet = 0, i, maxargc = 0;
+    const char *path = NULL;
+    double *scan_lat, *parse_lat;
+    long *reps;
+    long nscan = 0, nparse = 0, scan_args = 0, parse_args_n = 0, r;
+    char **scratch;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc)
+            rounds = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--quiet"))
+            quiet = 1;
+        else if (!strcmp(argv[i], "--sample") && i + 1 < argc)
+            return sample(argv[i + 1]);
+        else if (argv[i][0] == '-' || path)
+        {
+            usage();
+            return 2;
+        }
+        else
+            path = argv[i];
+    }
+    if (!path || rounds < 1)
+    {
+        usage();
+        return 2;
+    }
+
+    // the log says how each scan ordered its arguments; the environment
+    // of the replay must not change that
+    unsetenv("POSIXLY_CORRECT");
+    skipped = load(path);
+    if (skipped < 0)
+    {
+        fprintf(stderr, "getopt_replay: %s: not a getopt recording\n", path);
+        return 1;
+    }
+
+    for (i = 0; i < ncalls; i++)
+        if (calls[i].argc > maxargc)
+            maxargc = calls[i].argc;
+    scratch = malloc((maxargc + 1) * sizeof(char *));
+    scan_lat = malloc(rounds * ncalls * sizeof(double) + 1);
+    parse_lat = malloc(rounds * ncalls * sizeof(double) + 1);
+    reps = calloc(ncalls + 1, sizeof(long));
+
+    for (r = 0; r < rounds; r++)
+        for (i = 0; i < ncalls; i++)
+        {
+            struct call *c = &calls[i];
+            double t;
+
+            // first find how many repetitions make a batch
+            if (reps[i] == 0)
+                for (reps[i] = 1; reps[i] < (1L << 20); reps[i] *= 2)
+                {
+                    t = time_call(c, scratch, reps[i]);
+                    if (t < 0 || t >= MIN_BATCH)
+                        break;
+                }
+            t = time_call(c, scratch, reps[i]);
+            if (t < 0)
+            {
+                unreplayed += r == 0;
+                continue;
+            }
+            t /= reps[i];
+            if (c->type == GETOPT_RECORD_SCAN)
+            {
+                scan_lat[nscan++] = t;
+                scan_args += c->argc;
+            }
+            else
+            {
+                parse_lat[nparse++] = t;
+                parse_args_n += c->argc;
+            }
+        }
+
+    if (!quiet)
+        printf("%s: %d calls, %ld rounds, %ld records skipped, "
+               "%ld calls without their table\n",
+               path, ncalls, rounds, skipped, unreplayed);
+    report("getopt", scan_lat, nscan, scan_args);
+    report("parse_args", parse_lat, nparse, parse_args_n);
+    free(scan_lat);
+    free(parse_lat);
+    free(reps);
+    free(scratch);
+    return 0;
+}
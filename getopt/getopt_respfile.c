@@ -0,0 +1,403 @@
+/* Response files for getopt.
+   This file is distributed under the same terms as getopt.c.
+
+   An element `@FILE' of ARGV stands for the arguments written in FILE,
+   separated by white space, which may be quoted with `'' or `"' or
+   escaped with a backslash, as for GCC.  They may include further
+   `@FILE' elements.  A file that cannot be opened is not expanded, and
+   the element is passed on as it is.
+
+   Argument lists in response files can be far longer than ARG_MAX, so
+   nothing here is proportional to the number of arguments: each file is
+   mapped privately into memory, and the elements are handed to a
+   `struct getopt_stream' one at a time as views into the mapping.  Only
+   an argument with quotes or backslashes in it is written to, to remove
+   them, and that only touches the pages it is on.  The mappings are kept
+   until the whole expansion is freed, so every `optarg' stays valid as
+   long as the views do.  */
+
+#ifdef WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "getopt.h"
+#include "getopt_int.h"
+
+/* How deeply response files may name other ones.  This is also what
+   stops a file that names itself.  */
+#define RESPFILE_MAXDEPTH	64
+
+/* The bytes of one response file.  */
+struct respfile_map
+{
+  char *base;
+  size_t size;
+  int mapped;			/* Else BASE was allocated.  */
+  struct respfile_map *next;
+};
+
+/* A file being read: the part of it not tokenized yet.  */
+struct respfile_pos
+{
+  char *cur;
+  char *end;
+};
+
+struct getopt_respfile
+{
+  int argc;
+  char *const *argv;
+  int argi;
+  struct respfile_pos stack[RESPFILE_MAXDEPTH];
+  int depth;
+  struct respfile_map *maps;	/* All files read, newest first.  */
+  char *path;			/* Room for the name of the next file.  */
+  size_t pathsize;
+  int error;
+  struct getopt_view errfile;
+};
+
+struct getopt_respfile *
+getopt_respfile_new (int argc, char *const *argv)
+{
+  struct getopt_respfile *r;
+
+  r = (struct getopt_respfile *) malloc (sizeof *r);
+  if (r == NULL)
+    return NULL;
+  r->argc = argc;
+  r->argv = argv;
+  r->argi = 0;
+  r->depth = 0;
+  r->maps = NULL;
+  r->path = NULL;
+  r->pathsize = 0;
+  r->error = 0;
+  r->errfile.ptr = NULL;
+  r->errfile.len = 0;
+  return r;
+}
+
+void
+getopt_respfile_free (struct getopt_respfile *r)
+{
+  struct respfile_map *m, *next;
+
+  if (r == NULL)
+    return;
+  for (m = r->maps; m != NULL; m = next)
+    {
+      next = m->next;
+      if (!m->mapped)
+	free (m->base);
+#ifdef WIN32
+      else
+	UnmapViewOfFile (m->base);
+#else
+      else
+	munmap (m->base, m->size);
+#endif
+      free (m);
+    }
+  free (r->path);
+  free (r);
+}
+
+int
+getopt_respfile_error (const struct getopt_respfile *r,
+		       struct getopt_view *file)
+{
+  if (file != NULL)
+    *file = r->errfile;
+  return r->error;
+}
+
+/* Read all of FD into memory allocated for M, for files that cannot be
+   mapped, such as pipes.  */
+
+#ifndef WIN32
+static int
+read_file (int fd, struct respfile_map *m)
+{
+  size_t room = 4096;
+  ssize_t n;
+
+  m->base = (char *) malloc (room);
+  m->size = 0;
+  m->mapped = 0;
+  if (m->base == NULL)
+    return ENOMEM;
+  while ((n = read (fd, m->base + m->size, room - m->size)) != 0)
+    {
+      if (n < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  return errno;
+	}
+      m->size += n;
+      if (m->size == room)
+	{
+	  char *p = (char *) realloc (m->base, room * 2);
+
+	  if (p == NULL)
+	    return ENOMEM;
+	  m->base = p;
+	  room *= 2;
+	}
+    }
+  return 0;
+}
+#endif
+
+/* Map the file called PATH into M, writably but without ever writing to
+   the file.  Returns 0, ENOENT for a file to leave unexpanded, or an
+   error number.  */
+
+static int
+map_file (const char *path, struct respfile_map *m)
+{
+#ifdef WIN32
+  HANDLE file, mapping;
+  LARGE_INTEGER size;
+
+  m->base = NULL;
+  m->size = 0;
+  m->mapped = 0;
+  file = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ, NULL,
+		      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return ENOENT;
+  if (!GetFileSizeEx (file, &size))
+    {
+      CloseHandle (file);
+      return EIO;
+    }
+  if ((unsigned long long) size.QuadPart > SIZE_MAX)
+    {
+      CloseHandle (file);
+      return EFBIG;
+    }
+  if (size.QuadPart == 0)
+    {
+      CloseHandle (file);
+      return 0;
+    }
+  mapping = CreateFileMappingA (file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle (file);
+  if (mapping == NULL)
+    return ENOMEM;
+  m->base = (char *) MapViewOfFile (mapping, FILE_MAP_COPY, 0, 0, 0);
+  CloseHandle (mapping);
+  if (m->base == NULL)
+    return ENOMEM;
+  m->size = (size_t) size.QuadPart;
+  m->mapped = 1;
+  return 0;
+#else
+  struct stat st;
+  void *p;
+  int fd;
+  int err;
+
+  m->base = NULL;
+  m->size = 0;
+  m->mapped = 0;
+  do
+    fd = open (path, O_RDONLY);
+  while (fd < 0 && errno == EINTR);
+  if (fd < 0)
+    return ENOENT;
+  if (fstat (fd, &st) < 0 || !S_ISREG (st.st_mode))
+    {
+      err = read_file (fd, m);
+      close (fd);
+      return err;
+    }
+  if ((unsigned long long) st.st_size > SIZE_MAX)
+    {
+      close (fd);
+      return EFBIG;
+    }
+  if (st.st_size == 0)
+    {
+      close (fd);
+      return 0;
+    }
+  p = mmap (NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+	    fd, 0);
+  if (p == MAP_FAILED)
+    {
+      err = read_file (fd, m);
+      close (fd);
+      return err;
+    }
+# ifdef POSIX_MADV_SEQUENTIAL
+  posix_madvise (p, (size_t) st.st_size, POSIX_MADV_SEQUENTIAL);
+# endif
+  close (fd);
+  m->base = (char *) p;
+  m->size = (size_t) st.st_size;
+  m->mapped = 1;
+  return 0;
+#endif
+}
+
+#define IS_SPACE(c) \
+  ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r'		      \
+   || (c) == '\f' || (c) == '\v')
+
+/* Store in *ELT the next argument of the file at P, removing its quotes
+   and backslashes in place.  Returns zero at the end of the file.  */
+
+static int
+next_token (struct respfile_pos *p, struct getopt_view *elt)
+{
+  char *r = p->cur;
+  char *w;
+  char quote = 0;
+
+  while (r < p->end && IS_SPACE (*r))
+    r++;
+  if (r == p->end)
+    {
+      p->cur = r;
+      return 0;
+    }
+
+  /* Until the first quote or backslash, R and W stay equal and nothing
+     is written.  */
+  elt->ptr = w = r;
+  for (; r < p->end; r++)
+    {
+      char c = *r;
+
+      if (c == '\\')
+	{
+	  if (++r == p->end)
+	    break;
+	  c = *r;
+	}
+      else if (quote != 0 ? c == quote : c == '\'' || c == '"')
+	{
+	  quote = quote != 0 ? 0 : c;
+	  continue;
+	}
+      else if (quote == 0 && IS_SPACE (c))
+	break;
+      if (w != r)
+	*w = c;
+      w++;
+    }
+  elt->len = w - elt->ptr;
+  p->cur = r;
+  return 1;
+}
+
+/* Start reading the file named by the LEN bytes at NAME.  Returns zero
+   if it is to be passed on unexpanded, and -1 with R->error set if
+   expanding it failed.  */
+
+static int
+push_file (struct getopt_respfile *r, const char *name, size_t len)
+{
+  struct respfile_map *m;
+  int err;
+
+  if (r->pathsize < len + 1)
+    {
+      char *path = (char *) realloc (r->path, len + 1);
+
+      if (path == NULL)
+	{
+	  err = ENOMEM;
+	  goto fail;
+	}
+      r->path = path;
+      r->pathsize = len + 1;
+    }
+  memcpy (r->path, name, len);
+  r->path[len] = '\0';
+
+  if (r->depth == RESPFILE_MAXDEPTH)
+    {
+      err = ELOOP;
+      goto fail;
+    }
+  m = (struct respfile_map *) malloc (sizeof *m);
+  if (m == NULL)
+    {
+      err = ENOMEM;
+      goto fail;
+    }
+  err = map_file (r->path, m);
+  if (err == ENOENT)
+    {
+      free (m);
+      return 0;
+    }
+  m->next = r->maps;
+  r->maps = m;
+  if (err != 0)
+    goto fail;
+
+  r->stack[r->depth].cur = m->base;
+  r->stack[r->depth].end = m->base + m->size;
+  r->depth++;
+  return 1;
+
+ fail:
+  r->error = err;
+  r->errfile.ptr = name;
+  r->errfile.len = len;
+  return -1;
+}
+
+int
+getopt_respfile_next (void *cookie, struct getopt_view *elt)
+{
+  struct getopt_respfile *r = (struct getopt_respfile *) cookie;
+
+  if (r->error != 0)
+    return 0;
+  for (;;)
+    {
+      if (r->depth > 0)
+	{
+	  if (!next_token (&r->stack[r->depth - 1], elt))
+	    {
+	      r->depth--;
+	      continue;
+	    }
+	}
+      else if (r->argi < r->argc)
+	{
+	  elt->ptr = r->argv[r->argi];
+	  elt->len = strlen (elt->ptr);
+	  /* The program name is never expanded.  */
+	  if (r->argi++ == 0)
+	    return 1;
+	}
+      else
+	return 0;
+
+      if (elt->len < 2 || elt->ptr[0] != '@')
+	return 1;
+      switch (push_file (r, elt->ptr + 1, elt->len - 1))
+	{
+	case 0:
+	  return 1;
+	case -1:
+	  return 0;
+	}
+    }
+}
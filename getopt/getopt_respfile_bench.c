@@ -0,0 +1,213 @@
+// expanding a large @response-file: by hand into argv, and mapped
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+# include <windows.h>
+#endif
+
+static struct option long_options[] =
+{
+    {"add", required_argument, 0, 'a'},
+    {"append", no_argument, 0, 0},
+    {"delete", required_argument, 0, 0},
+    {"verbose", optional_argument, 0, 0},
+    {"create", no_argument, 0, 0},
+    {"file", required_argument, 0, 0},
+    {"help", no_argument, 0, 0},
+    {0, 0, 0, 0}
+};
+
+// operands are returned in order, as the stream scan does
+static char simple_options[] = "-a:bc::d:0123456789";
+
+// what a build system writes: mostly plain words, some quoted
+static const char *tokens[] =
+{
+    "-a", "value", "-b", "-c", "-cfoo", "-d", "17", "--add=x", "--append",
+    "--delete", "item", "--verbose=3", "--file", "/tmp/input/file.o",
+    "src/module/object_file_with_a_long_name.o", "-Iinclude/dir",
+    "\"path with spaces/x.h\"", "'single quoted'", "escaped\\ space",
+    "operand", "--cr", "--he",
+};
+
+#define NTOKENS (sizeof(tokens) / sizeof(tokens[0]))
+
+// a monotonic clock: the wall clock can step, and is coarse on some hosts
+double now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER t, f;
+    QueryPerformanceCounter(&t);
+    QueryPerformanceFrequency(&f);
+    return (double)t.QuadPart / f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+void usage(void)
+{
+    printf("usage: getopt_respfile_bench [megabytes] [response file]\n");
+}
+
+// write about MB megabytes of arguments to PATH
+long long generate(const char *path, long mb)
+{
+    FILE *f = fopen(path, "w");
+    long long size = 0, target = (long long)mb << 20;
+    unsigned seed = 1;
+
+    if (!f)
+        return -1;
+    while (size < target)
+    {
+        seed = seed * 1103515245 + 12345;
+        size += fprintf(f, "%s%c", tokens[(seed >> 16) % NTOKENS],
+                        (seed >> 8) % 8 ? ' ' : '\n');
+    }
+    fclose(f);
+    return size;
+}
+
+// the usual way: read the file, split it into a heap argv, one string
+// per argument, then scan that
+int by_hand(const char *prog, const char *path, long *nargs)
+{
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    FILE *f = fopen(path, "rb");
+    char *text, *p, *end;
+    char **argv;
+    long size, argc = 1, room = 1024;
+    int c, n = 0;
+
+    if (!f)
+        return -1;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    text = (char *)malloc(size);
+    argv = (char **)malloc(room * sizeof(char *));
+    if (!text || !argv || fread(text, 1, size, f) != (size_t)size)
+        return -1;
+    fclose(f);
+
+    argv[0] = (char *)prog;
+    for (p = text, end = text + size; p < end; )
+    {
+        char *arg, *w;
+        char quote = 0;
+
+        while (p < end && (*p == ' ' || *p == '\n'))
+            ++p;
+        if (p == end)
+            break;
+        arg = w = p;
+        for (; p < end && (quote || (*p != ' ' && *p != '\n')); ++p)
+        {
+            if (*p == '\\' && p + 1 < end)
+                *w++ = *++p;
+            else if (quote ? *p == quote : *p == '\'' || *p == '"')
+                quote = quote ? 0 : *p;
+            else
+                *w++ = *p;
+        }
+        if (argc + 1 == room)
+            argv = (char **)realloc(argv, (room *= 2) * sizeof(char *));
+        argv[argc] = (char *)malloc(w - arg + 1);
+        memcpy(argv[argc], arg, w - arg);
+        argv[argc++][w - arg] = '\0';
+    }
+    argv[argc] = 0;
+    free(text);
+
+    state.opterr = 0;
+    while ((c = getopt_long_r((int)argc, argv, simple_options, long_options,
+                              0, &state)) != -1)
+        n += c != 1;
+    *nargs = argc - 1;
+
+    while (--argc > 0)
+        free(argv[argc]);
+    free(argv);
+    return n;
+}
+
+// getopt_respfile: the file is mapped and scanned in place
+int mapped(const char *prog, const char *path, long *nargs)
+{
+    char at[4096];
+    char *argv[] = {(char *)prog, at, 0};
+    struct getopt_spec *spec = getopt_compile(simple_options, long_options);
+    struct getopt_respfile *r;
+    struct getopt_stream stream;
+    int c, n = 0;
+
+    snprintf(at, sizeof(at), "@%s", path);
+    r = getopt_respfile_new(2, argv);
+    if (!spec || !r)
+        return -1;
+    getopt_stream_init(&stream, getopt_respfile_next, r);
+    stream.state.opterr = 0;
+    while ((c = getopt_long_stream_r(&stream, spec, 0)) != -1)
+        n += c != 1;
+    *nargs = stream.state.optind - 1;
+    if (getopt_respfile_error(r, 0))
+        n = -1;
+
+    getopt_respfile_free(r);
+    getopt_spec_free(spec);
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    long mb = argc > 1 ? atol(argv[1]) : 256;
+    const char *path = argc > 2 ? argv[2] : "getopt_respfile_bench.rsp";
+    long long size;
+    long nargs1 = 0, nargs2 = 0;
+    double t0, t1, t2;
+    int n1, n2;
+
+    if (mb <= 0)
+    {
+        usage();
+        return 1;
+    }
+
+    size = generate(path, mb);
+    if (size < 0)
+    {
+        printf("cannot write %s\n", path);
+        return 1;
+    }
+    printf("%s: %.1f MB\n", path, size / 1048576.0);
+
+    t0 = now();
+    n1 = by_hand(argv[0], path, &nargs1);
+    t1 = now();
+    n2 = mapped(argv[0], path, &nargs2);
+    t2 = now();
+    remove(path);
+
+    if (n1 < 0 || n2 < 0)
+    {
+        printf("cannot read %s\n", path);
+        return 1;
+    }
+    printf("by hand:  %ld args, %d options, %7.3f s, %7.1f MB/s, %6.1f ns/arg\n",
+           nargs1, n1, t1 - t0, size / 1048576.0 / (t1 - t0),
+           (t1 - t0) * 1e9 / nargs1);
+    printf("mapped:   %ld args, %d options, %7.3f s, %7.1f MB/s, %6.1f ns/arg\n",
+           nargs2, n2, t2 - t1, size / 1048576.0 / (t2 - t1),
+           (t2 - t1) * 1e9 / nargs2);
+    if (n1 != n2 || nargs1 != nargs2)
+        printf("the two scans disagree\n");
+    return 0;
+}
@@ -0,0 +1,100 @@
+/* Compiled option specifications for getopt.
+   This file is distributed under the same terms as getopt.c.
+
+   Every call of `_getopt_internal' looks each option character up in
+   OPTSTRING again, and every new scan re-reads the leading `-', `+' and
+   `:' and asks the environment for POSIXLY_CORRECT.  `getopt_compile'
+   does all of that once and records the answers in a `struct getopt_spec'
+   that the `*_spec_r' entry points consult instead.  */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "getopt.h"
+#include "getopt_int.h"
+
+int
+_getopt_short_flags (const char *temp)
+{
+  int flags;
+
+  if (temp == NULL)
+    return 0;
+  flags = SHORT_LISTED;
+  if (temp[0] == 'W' && temp[1] == ';')
+    flags |= SHORT_W;
+  if (temp[1] == ':')
+    {
+      flags |= SHORT_ARG;
+      if (temp[2] == ':')
+	flags |= SHORT_OPTIONAL;
+    }
+  return flags;
+}
+
+int
+_getopt_colon_p (const char *optstring)
+{
+  if (optstring[0] == '-' || optstring[0] == '+')
+    optstring++;
+  return optstring[0] == ':';
+}
+
+struct getopt_spec *
+getopt_compile (const char *optstring, const struct option *longopts)
+{
+  struct getopt_spec *spec;
+  const char *p;
+
+  spec = (struct getopt_spec *) malloc (sizeof *spec);
+  if (spec == NULL)
+    return NULL;
+
+  spec->posixly_correct = getenv ("POSIXLY_CORRECT") != NULL;
+  spec->colon = _getopt_colon_p (optstring);
+  if (optstring[0] == '-')
+    {
+      spec->ordering = RETURN_IN_ORDER;
+      ++optstring;
+    }
+  else if (optstring[0] == '+')
+    {
+      spec->ordering = REQUIRE_ORDER;
+      ++optstring;
+    }
+  else if (spec->posixly_correct)
+    spec->ordering = REQUIRE_ORDER;
+  else
+    spec->ordering = PERMUTE;
+  spec->optstring = optstring;
+
+  /* A character is described by its first occurrence, which is the one
+     a search of OPTSTRING would find.  */
+  memset (spec->shortopts, 0, sizeof spec->shortopts);
+  for (p = optstring; *p; p++)
+    if (spec->shortopts[(unsigned char) *p] == 0)
+      spec->shortopts[(unsigned char) *p] = _getopt_short_flags (p);
+
+  spec->longopts = longopts;
+  spec->longindex = NULL;
+  spec->longmatch = NULL;
+  if (longopts != NULL)
+    {
+      spec->longindex = getopt_longindex_new (longopts);
+      if (spec->longindex == NULL)
+	{
+	  free (spec);
+	  return NULL;
+	}
+    }
+  return spec;
+}
+
+void
+getopt_spec_free (struct getopt_spec *spec)
+{
+  if (spec == NULL)
+    return;
+  getopt_longindex_free (spec->longindex);
+  free (spec);
+}
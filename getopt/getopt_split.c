@@ -0,0 +1,156 @@
+/* Splitting a command line into arguments for getopt.
+   This file is distributed under the same terms as getopt.c.
+
+   `getopt_split' breaks a string into words the way a POSIX shell does
+   before any expansion: at unquoted blanks and newlines, with quotes
+   removed and backslashes applied.  Removing quotes only ever shortens a
+   word, so every word is written back over the bytes it came from, just
+   behind the point being read, and ends with a NUL where its delimiter
+   was.  The input is read once, and the only memory used besides it is
+   the vector of pointers, which is taken from the caller's arena.  */
+
+#include <stddef.h>
+
+#include "getopt.h"
+#include "getopt_int.h"
+
+#define IS_BLANK(c) ((c) == ' ' || (c) == '\t' || (c) == '\n')
+
+/* Take room for N more pointers at the end of ARENA, aligned for them.  */
+
+static char **
+arena_take (struct getopt_arena *arena, size_t n)
+{
+  size_t align = (size_t) (arena->base + arena->used) % sizeof (char *);
+  size_t pad = align != 0 ? sizeof (char *) - align : 0;
+
+  if (arena->used + pad > arena->size
+      || (arena->size - arena->used - pad) / sizeof (char *) < n)
+    return NULL;
+  arena->used += pad + n * sizeof (char *);
+  return (char **) (arena->base + arena->used) - n;
+}
+
+int
+getopt_split (char *line, char *progname, struct getopt_arena *arena,
+	      char ***argvp)
+{
+  size_t start = arena->used;
+  char **argv = NULL;
+  int argc = 0;
+  char *r = line;
+  char *w;
+  char **slot;
+
+  /* The pointers are taken one at a time as the words end, so they stay
+     contiguous as long as nothing else uses the arena meanwhile.  */
+#define PUSH(p) \
+  do									      \
+    {									      \
+      slot = arena_take (arena, 1);					      \
+      if (slot == NULL)							      \
+	goto nospace;							      \
+      if (argv == NULL)							      \
+	argv = slot;							      \
+      *slot = (p);							      \
+      argc++;								      \
+    }									      \
+  while (0)
+
+  if (progname != NULL)
+    PUSH (progname);
+
+  for (;;)
+    {
+      char *word;
+      int quoted = 0;
+
+      while (IS_BLANK (*r))
+	r++;
+      if (*r == '\0')
+	break;
+
+      /* Until the first quote or backslash, R and W stay equal.  */
+      word = w = r;
+      while (*r != '\0' && !IS_BLANK (*r))
+	switch (*r)
+	  {
+	  case '\\':
+	    /* A backslash quotes the next character; before a newline it
+	       continues the line and is removed with it.  */
+	    if (r[1] == '\0')
+	      {
+		r++;
+		break;
+	      }
+	    if (r[1] != '\n')
+	      {
+		*w++ = r[1];
+		quoted = 1;
+	      }
+	    r += 2;
+	    break;
+
+	  case '\'':
+	    /* Everything up to the next single quote is literal.  */
+	    quoted = 1;
+	    for (r++; *r != '\'' && *r != '\0'; r++)
+	      *w++ = *r;
+	    if (*r == '\0')
+	      goto unterminated;
+	    r++;
+	    break;
+
+	  case '"':
+	    /* Inside double quotes a backslash only quotes the characters
+	       that would be special there, and is kept otherwise.  */
+	    quoted = 1;
+	    for (r++; *r != '"' && *r != '\0'; r++)
+	      if (*r == '\\' && (r[1] == '"' || r[1] == '\\' || r[1] == '$'
+				 || r[1] == '`' || r[1] == '\n'))
+		{
+		  if (*++r != '\n')
+		    *w++ = *r;
+		}
+	      else
+		*w++ = *r;
+	    if (*r == '\0')
+	      goto unterminated;
+	    r++;
+	    break;
+
+	  default:
+	    if (w != r)
+	      *w = *r;
+	    w++;
+	    r++;
+	  }
+
+      /* W is at most R, which is at the delimiter or the final NUL.  */
+      if (*r != '\0')
+	r++;
+      *w = '\0';
+      /* Only quotes make an empty word; a lone line continuation does
+	 not.  */
+      if (w != word || quoted)
+	PUSH (word);
+    }
+#undef PUSH
+
+  slot = arena_take (arena, 1);
+  if (slot == NULL)
+    goto nospace;
+  if (argv == NULL)
+    argv = slot;
+  *slot = NULL;
+  *argvp = argv;
+  return argc;
+
+ unterminated:
+  arena->used = start;
+  return GETOPT_SPLIT_UNTERMINATED;
+
+ nospace:
+  arena->used = start;
+  return GETOPT_SPLIT_NOSPACE;
+}
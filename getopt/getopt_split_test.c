@@ -0,0 +1,78 @@
+// test getopt_split: a REPL reading one command line at a time
+
+#include <getopt.h>
+#include <stdio.h>
+#include <string.h>
+
+static struct option long_options[] =
+{
+    {"add", required_argument, 0, 'a'},
+    {"append", no_argument, 0, 0},
+    {"delete", required_argument, 0, 0},
+    {"verbose", optional_argument, 0, 0},
+    {"help", no_argument, 0, 'h'},
+    {0, 0, 0, 0}
+};
+
+static char simple_options[] = "a:bc::h";
+
+void usage()
+{
+    printf("usage: getopt_split_test < lines\n");
+    printf("each line is split like a shell would and scanned for [-%s]\n",
+           simple_options);
+}
+
+void run(int argc, char **argv)
+{
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    int c, longindex;
+
+    while ((c = getopt_long_r(argc, argv, simple_options, long_options,
+                              &longindex, &state)) != -1)
+    {
+        if (c == '?')
+            continue;
+        if (c == 'h')
+            usage();
+        else if (c == 0)
+            printf("option %s", long_options[longindex].name);
+        else
+            printf("option %c", c);
+        if (state.optarg)
+            printf(" with arg '%s'", state.optarg);
+        printf("\n");
+    }
+
+    while (state.optind < argc)
+        printf("operand '%s'\n", argv[state.optind++]);
+}
+
+int main(int argc, char **argv)
+{
+    char line[1024];
+    // enough for any line that fits above: no allocation per line
+    char room[GETOPT_SPLIT_ARENA_SIZE(sizeof(line))];
+    struct getopt_arena arena = {room, sizeof(room), 0};
+    char **args;
+    int n;
+
+    if (argc > 1)
+    {
+        usage();
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), stdin))
+    {
+        arena.used = 0;
+        n = getopt_split(line, argv[0], &arena, &args);
+        if (n == GETOPT_SPLIT_UNTERMINATED)
+            printf("unterminated quote\n");
+        else if (n == GETOPT_SPLIT_NOSPACE)
+            printf("line too long\n");
+        else
+            run(n, args);
+    }
+    return 0;
+}
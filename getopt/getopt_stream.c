@@ -0,0 +1,154 @@
+/* Pull-based argument source for getopt.
+   This file is distributed under the same terms as getopt.c.
+
+   The other entry points need all of ARGV before the scan starts.  A
+   `struct getopt_stream' instead asks a SOURCE function for one element
+   at a time and holds only the program name, the element being decoded
+   and two elements of lookahead, which is all an option and its argument
+   can span: `-W NAME ARG' for a long option NAME that requires one.  The
+   elements in the window are handed to the view scanner with `optind'
+   and the index of the element being decoded rebased to the window, so
+   the decoding is the same as for `getopt_long_view_r'.  */
+
+#include <string.h>
+
+#include "getopt.h"
+#include "getopt_int.h"
+
+void
+getopt_stream_init (struct getopt_stream *s,
+		    int (*source) (void *, struct getopt_view *),
+		    void *cookie)
+{
+  static const struct getopt_state initial = GETOPT_STATE_INITIALIZER;
+
+  s->state = initial;
+  s->__source = source;
+  s->__cookie = cookie;
+  s->__nwindow = 0;
+  s->__started = 0;
+  s->__eof = 0;
+  s->__nomoreopts = 0;
+}
+
+/* Read elements from the source until the window holds N of them after
+   the program name, or the source is exhausted.  */
+
+static void
+fill_window (struct getopt_stream *s, int n)
+{
+  while (s->__nwindow < n && !s->__eof)
+    {
+      if (s->__source (s->__cookie, &s->__window[1 + s->__nwindow]))
+	s->__nwindow++;
+      else
+	s->__eof = 1;
+    }
+}
+
+/* Drop the first N elements after the program name from the window.  */
+
+static void
+consume (struct getopt_stream *s, int n)
+{
+  int i;
+
+  for (i = 1; i + n <= s->__nwindow; i++)
+    s->__window[i] = s->__window[i + n];
+  s->__nwindow -= n;
+  s->state.optind += n;
+}
+
+/* Return the first element of the window as an operand.  */
+
+static int
+operand (struct getopt_stream *s)
+{
+  struct getopt_state *d = &s->state;
+
+  d->__argind = d->optind;
+  d->optarg = (char *) s->__window[1].ptr;
+  d->optarglen = s->__window[1].len;
+  consume (s, 1);
+  return 1;
+}
+
+static int
+stream_scan (struct getopt_stream *s, const struct getopt_spec *spec,
+	     int *longind, int long_only)
+{
+  struct getopt_state *d = &s->state;
+  const struct getopt_view *elt;
+  int base;
+  int used;
+  int result;
+
+  d->optarg = NULL;
+  if (!s->__started)
+    {
+      s->__started = 1;
+      if (!s->__source (s->__cookie, &s->__window[0]))
+	{
+	  s->__eof = 1;
+	  return -1;
+	}
+      d->optind = 1;
+    }
+
+  fill_window (s, 3);
+  if (s->__nwindow == 0)
+    return -1;
+
+  if (s->__nomoreopts)
+    return operand (s);
+
+  /* Between elements, deal with `--' and non-options here; the scanner
+     only ever sees option elements and their arguments.  */
+  if (d->__nextchar == NULL || d->__nextchar == d->__end)
+    {
+      elt = &s->__window[1];
+      if (elt->len == 2 && !memcmp (elt->ptr, "--", 2))
+	{
+	  consume (s, 1);
+	  s->__nomoreopts = 1;
+	  fill_window (s, 1);
+	  return s->__nwindow ? operand (s) : -1;
+	}
+      if (elt->len < 2 || elt->ptr[0] != '-' || elt->ptr[1] == '\0')
+	{
+	  if (spec->ordering == REQUIRE_ORDER)
+	    s->__nomoreopts = 1;
+	  return operand (s);
+	}
+    }
+
+  /* `__argind' is only set when an element is started, so in the middle
+     of a cluster it still holds the index found by an earlier call; it is
+     rebased into the window and back like `optind'.  */
+  base = d->optind;
+  d->optind = 1;
+  d->__argbase = base - 1;
+  d->__argind -= d->__argbase;
+  /* The window is not the command line, so it is not recorded.  */
+  result = _getopt_view_internal_r (1 + s->__nwindow, s->__window, spec,
+				    longind, long_only | _GETOPT_NORECORD, d);
+  used = d->optind - 1;
+  d->__argind += d->__argbase;
+  d->optind = base;
+  consume (s, used);
+  return result;
+}
+
+int
+getopt_long_stream_r (struct getopt_stream *s,
+		      const struct getopt_spec *spec, int *longind)
+{
+  return stream_scan (s, spec, longind, 0);
+}
+
+int
+getopt_long_only_stream_r (struct getopt_stream *s,
+			   const struct getopt_spec *spec, int *longind)
+{
+  return stream_scan (s, spec, longind, 1);
+}
@@ -0,0 +1,194 @@
+// test getopt_long_stream_r against getopt_long_view_r
+//
+// Run without arguments, it scans each built-in command line both ways
+// and fails if the options, arguments and operands found differ, or if
+// an option in a cluster is placed at the wrong index.  Run with
+// arguments, it prints what the stream finds in them.
+
+#include <getopt.h>
+#include <stdio.h>
+#include <string.h>
+
+static struct option long_options[] =
+{
+    {"file", required_argument, 0, 0},
+    {"level", optional_argument, 0, 0},
+    {"quiet", no_argument, 0, 0},
+    {0, 0, 0, 0}
+};
+
+static char simple_options[] = "W;ab:c::";
+
+static const char *const cases[][8] =
+{
+    {"prog", "-W", "file", "x", 0},
+    {"prog", "-W", "file", 0},
+    {"prog", "-aW", "file", "x", "y", 0},
+    {"prog", "-Wfile", "x", 0},
+    {"prog", "-W", "file=x", "-a", 0},
+    {"prog", "--file", "x", "y", 0},
+    {"prog", "--file=x", "--level", "z", 0},
+    {"prog", "-a", "--", "-b", "--file", 0},
+    {"prog", "one", "-b", "two", "three", 0},
+    {"prog", "-b", "--", "--", 0},
+    {"prog", "-c", "-cx", "--quiet", "-W", "quiet", 0},
+};
+
+#define NCASES (int)(sizeof(cases) / sizeof(cases[0]))
+
+// clusters that start past the first window, with the index in argv of
+// the element each option found is in, up to a 0
+static const struct
+{
+    const char *argv[8];
+    int argind[8];
+} clusters[] =
+{
+    {{"prog", "x", "y", "-aazz", 0}, {3, 3, 3, 3, 0}},
+    {{"prog", "x", "y", "z", "-azaz", 0}, {4, 4, 4, 4, 0}},
+    {{"prog", "-a", "x", "-zab", "y", "-z", 0}, {1, 3, 3, 3, 5, 0}},
+    {{"prog", "-ab", "v", "w", "-azc", "-z", 0}, {1, 1, 4, 4, 4, 5, 0}},
+};
+
+#define NCLUSTERS (int)(sizeof(clusters) / sizeof(clusters[0]))
+
+struct elements
+{
+    const char *const *argv;
+    int i;
+};
+
+int next_element(void *cookie, struct getopt_view *elt)
+{
+    struct elements *e = (struct elements *)cookie;
+
+    if (!e->argv[e->i])
+        return 0;
+    elt->ptr = e->argv[e->i];
+    elt->len = strlen(elt->ptr);
+    e->i++;
+    return 1;
+}
+
+// one line for each option found
+int describe(char *out, size_t size, int c, int longind, const struct getopt_state *state)
+{
+    int n;
+
+    if (c == 0)
+        n = snprintf(out, size, "--%s", long_options[longind].name);
+    else
+        n = snprintf(out, size, "-%c", c);
+    if (state->optarg)
+        n += snprintf(out + n, size - n, " '%.*s'", (int)state->optarglen, state->optarg);
+    return n + snprintf(out + n, size - n, "\n");
+}
+
+// the options in the order found, then the operands in order
+void scan_stream(const char *const *argv, const struct getopt_spec *spec, char *out, size_t size)
+{
+    struct elements e = {argv, 0};
+    struct getopt_stream stream;
+    char operands[512];
+    int c, longind = -1;
+    size_t n = 0, nop = 0;
+
+    getopt_stream_init(&stream, next_element, &e);
+    stream.state.opterr = 0;
+    while ((c = getopt_long_stream_r(&stream, spec, &longind)) != -1)
+    {
+        if (c == 1)
+            nop += snprintf(operands + nop, sizeof(operands) - nop, "operand '%.*s'\n",
+                            (int)stream.state.optarglen, stream.state.optarg);
+        else
+            n += describe(out + n, size - n, c, longind, &stream.state);
+    }
+    operands[nop] = 0;
+    snprintf(out + n, size - n, "%s", operands);
+}
+
+void scan_view(const char *const *argv, const struct getopt_spec *spec, char *out, size_t size)
+{
+    struct getopt_view views[8];
+    struct getopt_state state = GETOPT_STATE_INITIALIZER;
+    int operands[8];
+    int argc, c, i, longind = -1;
+    size_t n = 0;
+
+    for (argc = 0; argv[argc]; ++argc)
+    {
+        views[argc].ptr = argv[argc];
+        views[argc].len = strlen(argv[argc]);
+    }
+    state.opterr = 0;
+    state.operands = operands;
+    while ((c = getopt_long_view_r(argc, views, spec, &longind, &state)) != -1)
+        n += describe(out + n, size - n, c, longind, &state);
+    for (i = 0; i < state.noperands; ++i)
+        n += snprintf(out + n, size - n, "operand '%s'\n", argv[operands[i]]);
+    out[n] = 0;
+}
+
+// scan a cluster case through the stream and check where each option
+// was found: `__argind' is what the events of a scan report as `argind'
+int check_cluster(int i, const struct getopt_spec *spec)
+{
+    struct elements e = {clusters[i].argv, 0};
+    struct getopt_stream stream;
+    int argind[8];
+    int c, j, n = 0, failed = 0;
+
+    getopt_stream_init(&stream, next_element, &e);
+    stream.state.opterr = 0;
+    while ((c = getopt_long_stream_r(&stream, spec, 0)) != -1)
+        if (c != 1 && n < 8)
+            argind[n++] = stream.state.__argind;
+    for (j = 1; clusters[i].argv[j]; ++j)
+        printf("%s%s", j > 1 ? " " : "", clusters[i].argv[j]);
+    for (j = 0; j < 8 && clusters[i].argind[j]; ++j)
+        if (j >= n || argind[j] != clusters[i].argind[j])
+            failed = 1;
+    if (n != j)
+        failed = 1;
+    printf(": %s, options in", failed ? "FAILED" : "ok");
+    for (j = 0; j < n; ++j)
+        printf(" %d", argind[j]);
+    printf("\n");
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    struct getopt_spec *spec = getopt_compile(simple_options, long_options);
+    char stream[1024], view[1024];
+    int i, j, failed = 0;
+
+    if (!spec)
+        return 1;
+    if (argc > 1)
+    {
+        scan_stream((const char *const *)argv, spec, stream, sizeof(stream));
+        printf("%s", stream);
+        getopt_spec_free(spec);
+        return 0;
+    }
+
+    for (i = 0; i < NCASES; ++i)
+    {
+        scan_stream(cases[i], spec, stream, sizeof(stream));
+        scan_view(cases[i], spec, view, sizeof(view));
+        for (j = 1; cases[i][j]; ++j)
+            printf("%s%s", j > 1 ? " " : "", cases[i][j]);
+        if (strcmp(stream, view))
+        {
+            printf(": FAILED\nstream:\n%sview:\n%s", stream, view);
+            failed = 1;
+        }
+        else
+            printf(": ok\n%s", stream);
+    }
+    for (i = 0; i < NCLUSTERS; ++i)
+        failed |= check_cluster(i, spec);
+    getopt_spec_free(spec);
+    return failed;
+}
@@ -0,0 +1,175 @@
+// time of the suggestions for unknown and ambiguous long options
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+# include <windows.h>
+#endif
+
+#define NNAMES 5000
+#define NAMELEN 24
+#define LIMIT 0.001 // seconds per lookup
+
+// a monotonic clock: the wall clock can step, and is coarse on some hosts
+double now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER t, f;
+    QueryPerformanceCounter(&t);
+    QueryPerformanceFrequency(&f);
+    return (double)t.QuadPart / f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+void usage(void)
+{
+    printf("usage: getopt_suggest_bench [lookups] [rounds]\n");
+}
+
+static char names[NNAMES][NAMELEN];
+static struct option long_options[NNAMES + 1];
+
+// errors are only counted, so that nothing is printed
+static void count_error(void *cookie, const struct getopt_error *err)
+{
+    int *suggested = (int *)cookie;
+    if (err->nsuggestions > 0)
+        ++*suggested;
+}
+
+// the slowest of LOOKUPS scans of "--NAME", each the best of ROUNDS so
+// that a scan the scheduler happened to interrupt does not count
+static double time_scans(const char *what, char **args, int lookups,
+                         int rounds,
+                         const struct getopt_longindex *longindex,
+                         const struct getopt_nameindex *nameindex)
+{
+    double worst = 0, total = 0;
+    int suggested = 0;
+    int i, r;
+
+    for (i = 0; i < lookups; ++i)
+    {
+        double best = 0;
+
+        for (r = 0; r < rounds; ++r)
+        {
+            struct getopt_state state = GETOPT_STATE_INITIALIZER;
+            char *argv[3];
+            double start, elapsed;
+
+            argv[0] = "bench";
+            argv[1] = args[i];
+            argv[2] = NULL;
+            state.longindex = longindex;
+            state.nameindex = nameindex;
+            state.error = count_error;
+            state.error_cookie = &suggested;
+
+            start = now();
+            while (getopt_long_r(2, argv, "", long_options, NULL, &state) != -1)
+                ;
+            elapsed = now() - start;
+            getopt_state_release(&state);
+
+            if (best == 0 || elapsed < best)
+                best = elapsed;
+        }
+
+        total += best;
+        if (best > worst)
+            worst = best;
+    }
+
+    printf("%-12s %8.2f us mean  %8.2f us worst  (%d of %d suggested)  %s\n",
+           what, total / lookups * 1e6, worst * 1e6, suggested / rounds,
+           lookups, worst < LIMIT ? "ok" : "SLOW");
+    return worst;
+}
+
+int main(int argc, char **argv)
+{
+    int lookups = argc > 1 ? atoi(argv[1]) : 1000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+    struct getopt_longindex *longindex;
+    struct getopt_nameindex *nameindex;
+    char **misspelled, **ambiguous;
+    int i, j, failed = 0;
+
+    if (lookups <= 0 || rounds <= 0)
+    {
+        usage();
+        return 1;
+    }
+
+    // names like "opt-kqzf-1234", sharing prefixes the way real ones do
+    srand(1);
+    for (i = 0; i < NNAMES; ++i)
+    {
+        char word[5];
+        for (j = 0; j < 4; ++j)
+            word[j] = 'a' + rand() % 26;
+        word[4] = '\0';
+        snprintf(names[i], NAMELEN, "opt-%s-%d", word, i);
+        long_options[i].name = names[i];
+        long_options[i].has_arg = no_argument;
+        long_options[i].val = i + 1; // or else they are not ambiguous
+    }
+
+    longindex = getopt_longindex_new(long_options);
+    nameindex = getopt_nameindex_new(&long_options[0].name, NNAMES,
+                                     sizeof(struct option));
+    misspelled = (char **)malloc(lookups * sizeof(char *));
+    ambiguous = (char **)malloc(lookups * sizeof(char *));
+    if (!longindex || !nameindex || !misspelled || !ambiguous)
+    {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    // one edit away from a name, or a prefix shared by several
+    for (i = 0; i < lookups; ++i)
+    {
+        const char *name = names[rand() % NNAMES];
+        size_t len = strlen(name);
+
+        misspelled[i] = (char *)malloc(NAMELEN + 3);
+        ambiguous[i] = (char *)malloc(NAMELEN + 3);
+        if (!misspelled[i] || !ambiguous[i])
+        {
+            printf("out of memory\n");
+            return 1;
+        }
+        strcpy(misspelled[i], "--");
+        strcat(misspelled[i], name);
+        misspelled[i][2 + 4 + rand() % (len - 4)] = '_';
+        strcpy(ambiguous[i], "--");
+        strncat(ambiguous[i], name, 5 + rand() % 2);
+    }
+
+    if (time_scans("misspelled", misspelled, lookups, rounds, longindex,
+                   nameindex) >= LIMIT)
+        failed = 1;
+    if (time_scans("ambiguous", ambiguous, lookups, rounds, longindex,
+                   nameindex) >= LIMIT)
+        failed = 1;
+
+    for (i = 0; i < lookups; ++i)
+    {
+        free(misspelled[i]);
+        free(ambiguous[i]);
+    }
+    free(misspelled);
+    free(ambiguous);
+    getopt_nameindex_free(nameindex);
+    getopt_longindex_free(longindex);
+    return failed;
+}
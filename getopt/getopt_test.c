@@ -2,6 +2,7 @@
 
 #include <getopt.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static struct option long_options[] =
@@ -30,19 +31,79 @@ void usage()
         else
             sprintf(opbuf, "[--%s] ", op->name);
 
-        strncat(buf, opbuf, sizeof(buf));
+        strncat(buf, opbuf, sizeof(buf) - strlen(buf) - 1);
     }
 
     printf("usage: getopt_test [-%s] %s", simple_options, buf);
 }
 
-int main (int argc, char **argv)
+// print one option the way both loops below report it
+void print_option(int c, int longindex, const char *arg, int argind, int *digit_optind)
 {
-    if(argc == 1)
+    switch (c)
     {
-        usage();
+        // long option
+        case 0:
+            printf("option %s", long_options[longindex].name);
+            if (arg)
+                printf(" with arg %s", arg);
+            printf("\n");
+            break;
+
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            if(*digit_optind != 0 && *digit_optind != argind)
+                printf("digits occur in two different argv-elements.\n");
+
+            *digit_optind = argind;
+            printf("option %c\n", c);
+            break;
+
+        case 'a':
+            printf("option a with value '%s'\n", arg);
+            break;
+
+        case 'b':
+            printf("option b\n");
+            break;
+
+        case 'c':
+            if(arg)
+                printf("option c with value '%s'\n", arg);
+            else
+                printf("option c\n");
+            break;
+
+        case '?':
+            break;
+
+        default:
+            printf("?? getopt returned character code 0%o ??\n", c);
+    } // switch
+}
+
+void print_operands(int argc, char **argv, int first)
+{
+    if (first < argc)
+    {
+        printf("non-option ARGV-elements: ");
+        while (first < argc)
+            printf("%s ", argv[first++]);
+        printf("\n");
     }
+}
 
+// classic loop: one getopt_long call per option
+void parse_loop(int argc, char **argv)
+{
     int c;
     int digit_optind = 0;
 
@@ -53,68 +114,74 @@ int main (int argc, char **argv)
 
         c = getopt_long(argc, argv, simple_options, long_options, &longindex);
         if (c == -1)
-        break;
-
-        switch (c)
-        {
-            // long option
-            case 0:
-                   printf("option %s", long_options[longindex].name);
-                   if (optarg)
-                       printf(" with arg %s", optarg);
-                   printf("\n");
-                   break;
-
-                break;
-
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-                if(digit_optind != 0 && digit_optind != this_option_optind)
-                    printf("digits occur in two different argv-elements.\n");
-
-                digit_optind = this_option_optind;
-                printf("option %c\n", c);
-                break;
-
-            case 'a':
-                printf("option a with value '%s'\n", optarg);
-                break;
-
-            case 'b':
-                printf("option b\n");
-                break;
-
-            case 'c':
-                if(optarg)
-                    printf("option c with value '%s'\n", optarg);
-                else
-                    printf("option c\n");
-                break;
-
-            case '?':
-                break;
-
-            default:
-                printf("?? getopt returned character code 0%o ??\n", c);
-        } // switch
+            break;
+
+        print_option(c, longindex, optarg, this_option_optind, &digit_optind);
     } // while
 
-    if (optind < argc)
+    print_operands(argc, argv, optind);
+}
+
+// batch: compile the options once, scan the whole argv in one call,
+// leaving argv as it is and getting the operands as indices
+int parse_batch(int argc, char **argv)
+{
+    struct getopt_spec *spec = getopt_compile(simple_options, long_options);
+    struct getopt_event events[64];
+    int digit_optind = 0;
+    int *operands;
+    int noperands;
+    int i, n;
+
+    if (!spec)
+        return -1;
+
+    operands = (int *)malloc(argc * sizeof(int));
+    if (!operands)
+    {
+        getopt_spec_free(spec);
+        return -1;
+    }
+    n = getopt_parse_all_operands(argc, argv, spec, GETOPT_PARSE_QUIET,
+                                  events, sizeof(events) / sizeof(events[0]),
+                                  operands, &noperands);
+    if (n > (int)(sizeof(events) / sizeof(events[0])))
+        n = sizeof(events) / sizeof(events[0]);
+
+    for (i = 0; i < n; ++i)
+        print_option(events[i].opt, events[i].longind, events[i].optarg,
+                     events[i].argind, &digit_optind);
+
+    if (noperands > 0)
     {
         printf("non-option ARGV-elements: ");
-        while (optind < argc)
-        printf("%s ", argv[optind++]);
+        for (i = 0; i < noperands; ++i)
+            printf("%s ", argv[operands[i]]);
         printf("\n");
     }
 
+    free(operands);
+    getopt_spec_free(spec);
     return 0;
 }
 
+int main (int argc, char **argv)
+{
+    if(argc == 1)
+    {
+        usage();
+    }
+
+    // the batch scan does not permute argv, so it goes first
+    printf("getopt_parse_all_operands:\n");
+    if (parse_batch(argc, argv) != 0)
+    {
+        fprintf(stderr, "getopt_parse_all_operands: setup failed\n");
+        return 1;
+    }
+
+    printf("getopt_long:\n");
+    parse_loop(argc, argv);
+
+    return 0;
+}
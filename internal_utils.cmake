@@ -121,3 +121,24 @@ function(cxx_executable name dir libs)
     ${name} "${cxx_default}" "${libs}" "${dir}/${name}.cc" ${ARGN})
 endfunction()
 
+
+# cxx_executable_with_options(name spec libs srcs...)
+#
+# creates a named executable like cxx_executable_with_flags, and before
+# building it runs getopt_gen on the given option spec file.  The
+# generated matcher spec_name.c is compiled into the executable, and its
+# declarations are in spec_name.h in the binary directory, where spec_name
+# is the file name of spec without extension.
+function(cxx_executable_with_options name spec libs)
+  get_filename_component(prefix "${spec}" NAME_WE)
+  set(out "${CMAKE_CURRENT_BINARY_DIR}/${prefix}")
+  add_custom_command(
+    OUTPUT "${out}.c" "${out}.h"
+    COMMAND getopt_gen "${spec}" "${prefix}" "${out}.c" "${out}.h"
+    DEPENDS getopt_gen "${spec}"
+    COMMENT "Generating the option matcher ${prefix}.c")
+  cxx_executable_with_flags(
+    ${name} "${cxx_default}" "${libs}" "${out}.c" "${out}.h" ${ARGN})
+  set_property(TARGET ${name}
+    APPEND PROPERTY INCLUDE_DIRECTORIES "${CMAKE_CURRENT_BINARY_DIR}")
+endfunction()
@@ -16,11 +16,25 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 #include "moduleparam.h"
+#include "getopt.h"
+#include "getopt_probe.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <errno.h>
+#include <limits.h>
 #include <string.h>
 
+#ifdef WIN32
+# include <io.h>
+# include <fcntl.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
 #ifndef __APPLE__
 # include <malloc.h>
 #endif
@@ -51,40 +65,274 @@ static inline char dash2underscore(char c)
 	return c;
 }
 
-static inline int parameq(const char *input, const char *paramname)
+/* The name is the first n bytes of input, which need not end there. */
+static inline int parameqn(const char *input, size_t n, const char *paramname)
 {
-	unsigned int i;
-	for (i = 0; dash2underscore(input[i]) == paramname[i]; i++)
-		if (input[i] == '\0')
-			return 1;
-	return 0;
+	size_t i;
+	for (i = 0; i < n; i++)
+		if (dash2underscore(input[i]) != paramname[i])
+			return 0;
+	return paramname[n] == '\0';
+}
+
+/*
+ * The index is open addressing over the param numbers, hashed on the name
+ * with dashes read as underscores.  A name that has a dash itself can
+ * never be matched by parameqn, so it is left out; of several params with
+ * the same name only the first is found, as by a linear scan.
+ */
+struct param_index {
+	struct param_info *params;
+	int num;
+	unsigned int mask;
+	int *slots;		/* mask + 1 of them, -1 when empty */
+};
+
+static inline unsigned int param_hash(const char *name, size_t n)
+{
+	unsigned int h = 2166136261u;
+
+	while (n--)
+		h = (h ^ (unsigned char)dash2underscore(*name++)) * 16777619u;
+	return h;
+}
+
+static unsigned int param_index_size(int num)
+{
+	unsigned int size = 8;
+
+	while (size < 2 * (unsigned int)num)
+		size *= 2;
+	return size;
+}
+
+/* Fill in index over params, in the size slots given. */
+static void param_index_init(struct param_index *index,
+			     struct param_info *params, int num,
+			     int *slots, unsigned int size)
+{
+	unsigned int i, h;
+	int n;
+
+	index->params = params;
+	index->num = num;
+	index->mask = size - 1;
+	index->slots = slots;
+	for (i = 0; i < size; i++)
+		index->slots[i] = -1;
+
+	for (n = 0; n < num; n++) {
+		if (strchr(params[n].name, '-'))
+			continue;
+		for (h = param_hash(params[n].name, strlen(params[n].name)); ; h++) {
+			int *slot = &index->slots[h & index->mask];
+
+			if (*slot < 0) {
+				*slot = n;
+				break;
+			}
+			if (!strcmp(params[*slot].name, params[n].name))
+				break;
+		}
+	}
+}
+
+struct param_index *param_index_new(struct param_info *params, int num)
+{
+	unsigned int size = param_index_size(num);
+	struct param_index *index;
+
+	index = malloc(sizeof(*index) + size * sizeof(int));
+	if (!index)
+		return NULL;
+	param_index_init(index, params, num, (int *)(index + 1), size);
+	return index;
+}
+
+void param_index_free(struct param_index *index)
+{
+	free(index);
+}
+
+static struct param_info *param_index_lookup(const struct param_index *index,
+					     const char *name, size_t n)
+{
+	unsigned int h;
+
+	for (h = param_hash(name, n); ; h++) {
+		int i = index->slots[h & index->mask];
+
+		if (i < 0)
+			return NULL;
+		if (parameqn(name, n, index->params[i].name))
+			return &index->params[i];
+	}
+}
+
+struct param_info *param_index_find(const struct param_index *index,
+				    const char *name)
+{
+	return param_index_lookup(index, name, strlen(name));
+}
+
+/*
+ * The index a single parse builds for itself: on the stack for up to
+ * PARAM_INDEX_STACK params, so that parsing allocates nothing, and
+ * allocated for more, since searching that many in turn for every name
+ * costs more than the allocation; callers that mind it keep an index of
+ * their own, as moduleparam.h says.  None for fewer than PARAM_INDEX_MIN
+ * params, or if out of memory, and the params are then searched in turn.
+ */
+#define PARAM_INDEX_STACK 512
+
+struct call_index {
+	struct param_index index;
+	int slots[2 * PARAM_INDEX_STACK];
+};
+
+static struct param_index *call_index_get(struct call_index *ci,
+					  struct param_info *params, int num)
+{
+	unsigned int size = param_index_size(num);
+
+	if (num < PARAM_INDEX_MIN)
+		return NULL;
+	if (size > ARRAY_SIZE(ci->slots))
+		return param_index_new(params, num);
+	param_index_init(&ci->index, params, num, ci->slots, size);
+	return &ci->index;
 }
 
+static void call_index_put(struct call_index *ci, struct param_index *index)
+{
+	if (index != &ci->index)
+		param_index_free(index);
+}
+
+/* Names of unknown params up to this long are passed on from the stack. */
+#define UNKNOWN_NAME_LEN 256
+
+/*
+ * Set the param named by the first namelen bytes of param, which need
+ * not end there, as in an argv element "foo=bar".
+ */
 static int parse_one(char *param,
+		     size_t namelen,
 		     char *val,
 		     struct param_info *params, 
 		     unsigned num_params,
+		     const struct param_index *index,
 		     int (*handle_unknown)(char *param, char *val))
 {
+	struct param_info *kp = NULL;
 	unsigned int i;
+	int ret;
 
 	/* Find parameter */
-	for (i = 0; i < num_params; i++) {
-		if (parameq(param, params[i].name)) {
-			//DEBUGP("They are equal!  Calling %p\n", params[i].set);
-			return params[i].set(val, &params[i]);
+	if (index)
+		kp = param_index_lookup(index, param, namelen);
+	else
+		for (i = 0; i < num_params; i++) {
+			if (parameqn(param, namelen, params[i].name)) {
+				kp = &params[i];
+				break;
+			}
 		}
+
+	if (kp) {
+		//DEBUGP("They are equal!  Calling %p\n", kp->set);
+		GETOPT_PROBE2(moduleparam, param_set__entry, kp->name, val);
+		ret = kp->set(val, kp);
+		GETOPT_PROBE2(moduleparam, param_set__return, kp->name, ret);
+		return ret;
 	}
 
-	if (handle_unknown) {
+	if (handle_unknown && param[namelen] == '\0') {
 		//DEBUGP("Unknown argument: calling %p\n", handle_unknown);
 		return handle_unknown(param, val);
 	}
 
-	DEBUGP("Unknown argument '%s'\n", param);
+	if (handle_unknown) {
+		/* The handler wants the name on its own. */
+		char name[UNKNOWN_NAME_LEN], *copy = name;
+
+		if (namelen >= sizeof(name)) {
+			copy = malloc(namelen + 1);
+			if (!copy)
+				return -ENOMEM;
+		}
+		memcpy(copy, param, namelen);
+		copy[namelen] = '\0';
+		ret = handle_unknown(copy, val);
+		if (copy != name)
+			free(copy);
+		return ret;
+	}
+
+	DEBUGP("Unknown argument '%.*s'\n", (int)namelen, param);
 	return -ENOENT;
 }
 
+static param_set_view_fn param_view_setter(param_set_fn set);
+
+/* parse_one for a name and a value that are views. */
+static int parse_one_view(const char *param,
+			  size_t namelen,
+			  const char *val,
+			  size_t vallen,
+			  struct param_info *params,
+			  unsigned num_params,
+			  const struct param_index *index,
+			  param_unknown_view_fn handle_unknown)
+{
+	struct param_info *kp = NULL;
+	param_set_view_fn set_view;
+	unsigned int i;
+	int ret;
+
+	if (index)
+		kp = param_index_lookup(index, param, namelen);
+	else
+		for (i = 0; i < num_params; i++) {
+			if (parameqn(param, namelen, params[i].name)) {
+				kp = &params[i];
+				break;
+			}
+		}
+
+	if (!kp) {
+		if (handle_unknown)
+			return handle_unknown(param, namelen, val, vallen);
+		DEBUGP("Unknown argument '%.*s'\n", (int)namelen, param);
+		return -ENOENT;
+	}
+
+	GETOPT_PROBE3(moduleparam, param_set_view__entry, kp->name, val,
+		      vallen);
+	set_view = param_view_setter(kp->set);
+	if (set_view)
+		ret = set_view(val, vallen, kp);
+	else if (!val)
+		ret = kp->set(NULL, kp);
+	else {
+		/* A setter of its own needs the value with a NUL. */
+		char buf[UNKNOWN_NAME_LEN], *copy = buf;
+
+		if (vallen >= sizeof(buf)) {
+			copy = malloc(vallen + 1);
+			if (!copy)
+				return -ENOMEM;
+		}
+		memcpy(copy, val, vallen);
+		copy[vallen] = '\0';
+		ret = kp->set(copy, kp);
+		if (copy != buf)
+			free(copy);
+	}
+	GETOPT_PROBE2(moduleparam, param_set__return, kp->name, ret);
+	return ret;
+}
+
 /* You can use " around spaces, but can't escape ". */
 /* Hyphens and underscores equivalent in parameter names. */
 static char *next_arg(char *args, char **param, char **val)
@@ -137,41 +385,333 @@ static char *next_arg(char *args, char **param, char **val)
 	return skip_spaces(next);
 }
 
-/* Args looks like "foo=bar,bar2 baz=fuz wiz". */
-int parse_args(struct param_info *params,
+static const char *skip_spaces_view(const char *p, const char *end)
+{
+	while (p < end && isspace((unsigned char)*p))
+		p++;
+	return p;
+}
+
+/*
+ * next_arg for the bytes from args up to end, which are left alone: the
+ * name and value found are the views it would have cut out.  val is NULL
+ * without an equals sign.
+ */
+static const char *next_arg_view(const char *args, const char *end,
+				 const char **param, size_t *paramlen,
+				 const char **val, size_t *vallen)
+{
+	size_t i, equals = 0;
+	int in_quote = 0, quoted = 0;
+	const char *valend;
+
+	if (args < end && *args == '"') {
+		args++;
+		in_quote = 1;
+		quoted = 1;
+	}
+
+	for (i = 0; args + i < end; i++) {
+		if (isspace((unsigned char)args[i]) && !in_quote)
+			break;
+		if (equals == 0) {
+			if (args[i] == '=')
+				equals = i;
+		}
+		if (args[i] == '"')
+			in_quote = !in_quote;
+	}
+
+	*param = args;
+	if (!equals) {
+		*paramlen = i;
+		*val = NULL;
+		*vallen = 0;
+	} else {
+		*paramlen = equals;
+		*val = args + equals + 1;
+		valend = args + i;
+
+		/* Don't include quotes in value. */
+		if (*val < valend && **val == '"') {
+			(*val)++;
+			if (args[i-1] == '"')
+				valend = args + i - 1;
+		}
+		if (quoted && args[i-1] == '"')
+			valend = args + i - 1;
+		*vallen = valend > *val ? (size_t)(valend - *val) : 0;
+	}
+
+	if (args + i < end)
+		i++;
+
+	/* Chew up trailing spaces. */
+	return skip_spaces_view(args + i, end);
+}
+
+static const param_set_fn param_kind_setters[] = {
+	[PARAM_KIND_BYTE] = param_set_byte,
+	[PARAM_KIND_SHORT] = param_set_short,
+	[PARAM_KIND_USHORT] = param_set_ushort,
+	[PARAM_KIND_INT] = param_set_int,
+	[PARAM_KIND_UINT] = param_set_uint,
+	[PARAM_KIND_LONG] = param_set_long,
+	[PARAM_KIND_ULONG] = param_set_ulong,
+	[PARAM_KIND_BOOL] = param_set_bool,
+	[PARAM_KIND_INVBOOL] = param_set_invbool,
+	[PARAM_KIND_COPYSTRING] = param_set_copystring,
+};
+
+param_set_fn param_kind_set(int kind)
+{
+	if (kind <= PARAM_KIND_OTHER || kind >= (int)ARRAY_SIZE(param_kind_setters))
+		return NULL;
+	return param_kind_setters[kind];
+}
+
+static int param_kind(param_set_fn set)
+{
+	int kind;
+
+	for (kind = PARAM_KIND_OTHER + 1; kind < (int)ARRAY_SIZE(param_kind_setters); kind++)
+		if (param_kind_setters[kind] == set)
+			return kind;
+	return PARAM_KIND_OTHER;
+}
+
+static const param_set_view_fn param_kind_view_setters[] = {
+	[PARAM_KIND_BYTE] = param_set_byte_view,
+	[PARAM_KIND_SHORT] = param_set_short_view,
+	[PARAM_KIND_USHORT] = param_set_ushort_view,
+	[PARAM_KIND_INT] = param_set_int_view,
+	[PARAM_KIND_UINT] = param_set_uint_view,
+	[PARAM_KIND_LONG] = param_set_long_view,
+	[PARAM_KIND_ULONG] = param_set_ulong_view,
+	[PARAM_KIND_BOOL] = param_set_bool_view,
+	[PARAM_KIND_INVBOOL] = param_set_invbool_view,
+	[PARAM_KIND_COPYSTRING] = param_set_copystring_view,
+};
+
+/* The setter taking a view that does what set does, or NULL. */
+static param_set_view_fn param_view_setter(param_set_fn set)
+{
+	if (set == param_array_set)
+		return param_array_set_view;
+	return param_kind_view_setters[param_kind(set)];
+}
+
+static char *put(char *p, const void *src, size_t len)
+{
+	memcpy(p, src, len);
+	return p + len;
+}
+
+static char *put16(char *p, unsigned int v)
+{
+	uint16_t x = v;
+	return put(p, &x, sizeof(x));
+}
+
+static char *put32(char *p, unsigned long v)
+{
+	uint32_t x = v;
+	return put(p, &x, sizeof(x));
+}
+
+static char *put64(char *p, const void *v)
+{
+	uint64_t x = (uintptr_t)v;
+	return put(p, &x, sizeof(x));
+}
+
+/* What the recording says of a param besides its name. */
+struct record_param {
+	unsigned long kind, flags, max, size;
+};
+
+static void record_param_info(const struct param_info *kp,
+			      struct record_param *rp)
+{
+	rp->kind = param_kind(kp->set);
+	rp->flags = kp->flags;
+	rp->max = 0;
+	rp->size = 0;
+	if (kp->set == param_array_set) {
+		rp->kind = PARAM_KIND_ARRAY | param_kind(kp->arr->set);
+		rp->max = kp->arr->max;
+		rp->size = kp->arr->elemsize;
+	} else if (rp->kind == PARAM_KIND_COPYSTRING)
+		rp->max = kp->str->maxlen;
+}
+
+/*
+ * Write the table of params to the recording, once for as long as it
+ * holds the same: per param its kind, flags, the room it has (max and
+ * elemsize of an array, maxlen of a string) and its name.
+ */
+static void record_params(const struct param_info *params, int num)
+{
+	struct record_param rp;
+	unsigned long long hash;
+	size_t len = 12;
+	char *p, *payload;
+	int i;
+
+	hash = getopt_record_hash(0, &num, sizeof(num));
+	for (i = 0; i < num; i++) {
+		size_t namelen = strlen(params[i].name);
+
+		record_param_info(&params[i], &rp);
+		hash = getopt_record_hash(hash, &rp, sizeof(rp));
+		hash = getopt_record_hash(hash, params[i].name, namelen + 1);
+		len += 14 + namelen;
+	}
+	if (!getopt_record_once(params, hash))
+		return;
+	payload = p = getopt_record_begin(GETOPT_RECORD_PARAMS, len);
+	if (!payload)
+		return;
+	p = put64(p, params);
+	p = put32(p, num);
+	for (i = 0; i < num; i++) {
+		const struct param_info *kp = &params[i];
+		size_t namelen = strlen(kp->name);
+
+		record_param_info(kp, &rp);
+		p = put16(p, rp.kind);
+		p = put16(p, rp.flags);
+		p = put32(p, rp.max);
+		p = put32(p, rp.size);
+		p = put16(p, namelen);
+		p = put(p, kp->name, namelen);
+	}
+	getopt_record_end(payload);
+}
+
+/*
+ * Write a call of parse_args to the recording, after its params.  The
+ * lengths of the arguments are in lens, or taken with strlen without.
+ */
+static void record_parse_args(const struct param_info *params, int num,
+			      int argc, char *const *argv, const size_t *lens,
+			      int flags)
+{
+	size_t len = 20;
+	char *p, *payload;
+	int i;
+
+	record_params(params, num);
+	for (i = 0; i < argc; i++)
+		len += 4 + (lens ? lens[i] : strlen(argv[i]));
+	payload = p = getopt_record_begin(GETOPT_RECORD_PARSE_ARGS, len);
+	if (!payload)
+		return;
+	p = put64(p, params);
+	p = put32(p, num);
+	p = put32(p, flags);
+	p = put32(p, argc);
+	for (i = 0; i < argc; i++) {
+		size_t arglen = lens ? lens[i] : strlen(argv[i]);
+
+		p = put32(p, arglen);
+		p = put(p, argv[i], arglen);
+	}
+	getopt_record_end(payload);
+}
+
+static void report(int ret, const char *param, size_t namelen,
+		   const char *val)
+{
+	switch (ret) {
+	case -ENOENT:
+		printk("Unknown parameter '%.*s'\n", (int)namelen, param);
+		break;
+	case -ENOSPC:
+		printk("'%s' too large for parameter '%.*s'\n", val ? val : "",
+		       (int)namelen, param);
+		break;
+	default:
+		printk("'%s' invalid for parameter '%.*s'\n", val ? val : "",
+		       (int)namelen, param);
+		break;
+	}
+}
+
+/*
+ * Each element of argv is one "foo=bar": the shell has already split and
+ * unquoted them, so the value is everything after the first '=', spaces
+ * and quotes included.  Nothing is written to argv or allocated.
+ */
+static int __parse_args(struct param_info *params,
         int num,
+        const struct param_index *index,
         int argc,
         char **argv,
         int (*unknown)(char *param, char *val))
 {
+	int i, ret = 0;
+
+	GETOPT_PROBE2(moduleparam, parse_args__entry, num, argc);
+	if (getopt_recording())
+		record_parse_args(params, num, argc, argv, NULL,
+				  unknown ? PARSE_ARGS_RECORD_UNKNOWN : 0);
 
 	// ignore the first argv
-	if (argc <= 1)
-		return 0;
+	for (i = 1; i < argc; i++) {
+		char *param = argv[i];
+		char *val = strchr(param, '=');
+		size_t namelen = val ? (size_t)(val++ - param) : strlen(param);
+
+		if (!*param)
+			continue;
+		ret = parse_one(param, namelen, val, params, num, index, unknown);
+		if (ret) {
+			report(ret, param, namelen, val);
+			break;
+		}
+	}
+
+	GETOPT_PROBE1(moduleparam, parse_args__return, ret);
+	return ret;
+}
 
-	argc -= 1;
-	argv += 1;
+int parse_args(struct param_info *params,
+        int num,
+        int argc,
+        char **argv,
+        int (*unknown)(char *param, char *val))
+{
+	struct call_index ci;
+	struct param_index *index = NULL;
+	int ret;
 
+	/* Hashing every name pays off once there are a few to look up. */
+	if (argc > 2)
+		index = call_index_get(&ci, params, num);
+	ret = __parse_args(params, num, index, argc, argv, unknown);
+	call_index_put(&ci, index);
+	return ret;
+}
+
+/* Args looks like "foo=bar,bar2 baz=fuz wiz". */
+int parse_args_string(struct param_info *params,
+        int num,
+        char *args,
+        int (*unknown)(char *param, char *val))
+{
+	struct call_index ci;
+	struct param_index *index;
 	char *param, *val;
-    int ret = 0;
-    char *args, *orig_args;
-
-    /* count args len */
-    int i;
-    int len = argc + 1;
-    for (i = 0; i < argc; ++i) {
-        len += strlen(argv[i]);
-    }
+	int ret = 0;
 
-    args = (char *)malloc(len);
-    orig_args = args;
-    args[0] = '\0';
+	GETOPT_PROBE2(moduleparam, parse_args__entry, num, 1);
+	if (getopt_recording())
+		record_parse_args(params, num, 1, &args, NULL,
+				  PARSE_ARGS_RECORD_STRING
+				  | (unknown ? PARSE_ARGS_RECORD_UNKNOWN : 0));
 
-    for (i = 0; i < argc; ++i) {
-        strncat(args, argv[i], len);
-        if(i < argc - 1)
-            strcat(args, " ");
-    }
+	index = call_index_get(&ci, params, num);
 
 	DEBUGP("Parsing ARGS: %s\n", args);
 
@@ -180,110 +720,508 @@ int parse_args(struct param_info *params,
 
 	while (*args) {
 		args = next_arg(args, &param, &val);
-		ret = parse_one(param, val, params, num, unknown);
-
-		switch (ret) {
-            case -ENOENT:
-                printk("Unknown parameter '%s'\n", param);
-                goto error;
-            case -ENOSPC:
-                printk("'%s' too large for parameter '%s'\n", val ? val : "", param);
-                goto error;
-            case 0:
-                break;
-            default:
-                printk("'%s' invalid for parameter '%s'\n", val ? val : "", param);
-                goto error;
+		ret = parse_one(param, strlen(param), val, params, num, index,
+				unknown);
+		if (ret) {
+			report(ret, param, strlen(param), val);
+			break;
 		}
 	}
 
-error:
-    free(orig_args);
+	call_index_put(&ci, index);
+	GETOPT_PROBE1(moduleparam, parse_args__return, ret);
+	return ret;
+}
+
+int parse_args_indexed(struct param_index *index,
+        int argc,
+        char **argv,
+        int (*unknown)(char *param, char *val))
+{
+	return __parse_args(index->params, index->num, index, argc, argv,
+			    unknown);
+}
+
+static int __parse_args_buf(struct param_info *params,
+        int num,
+        const struct param_index *index,
+        const char *buf,
+        size_t len,
+        param_unknown_view_fn unknown)
+{
+	const char *end = buf + len;
+	const char *param, *val;
+	size_t namelen, vallen;
+	int ret = 0;
+
+	GETOPT_PROBE2(moduleparam, parse_args__entry, num, 1);
+	if (getopt_recording())
+		record_parse_args(params, num, 1, (char *const *)&buf, &len,
+				  PARSE_ARGS_RECORD_BUF
+				  | (unknown ? PARSE_ARGS_RECORD_UNKNOWN : 0));
+
+	/* Chew leading spaces */
+	buf = skip_spaces_view(buf, end);
+
+	while (buf < end) {
+		buf = next_arg_view(buf, end, &param, &namelen, &val, &vallen);
+		ret = parse_one_view(param, namelen, val, vallen, params, num,
+				     index, unknown);
+		if (ret) {
+			printk("'%.*s' rejected for parameter '%.*s'\n",
+			       (int)vallen, val ? val : "", (int)namelen, param);
+			break;
+		}
+	}
+
+	GETOPT_PROBE1(moduleparam, parse_args__return, ret);
+	return ret;
+}
+
+int parse_args_buf(struct param_info *params,
+        int num,
+        const char *buf,
+        size_t len,
+        param_unknown_view_fn unknown)
+{
+	struct call_index ci;
+	struct param_index *index;
+	int ret;
+
+	index = call_index_get(&ci, params, num);
+	ret = __parse_args_buf(params, num, index, buf, len, unknown);
+	call_index_put(&ci, index);
+	return ret;
+}
+
+int parse_args_buf_indexed(struct param_index *index,
+        const char *buf,
+        size_t len,
+        param_unknown_view_fn unknown)
+{
+	return __parse_args_buf(index->params, index->num, index, buf, len,
+				unknown);
+}
+
+/*
+ * Parameter files have the syntax of parse_args_string, and besides a '#'
+ * starting a word comments out the rest of its line, and a backslash at
+ * the end of a line joins the next one to it, within a word too.
+ */
+
+/* The bytes that end a word, quote or continue a line: isspace, '"', '\\'. */
+static const unsigned char file_special[256] = {
+	[' '] = 1, ['\t'] = 1, ['\n'] = 1, ['\v'] = 1, ['\f'] = 1, ['\r'] = 1,
+	['"'] = 1, ['\\'] = 1,
+};
+
+/*
+ * Find the next word of a parameter file in [*pp, end).  Returns 1 with
+ * the word in [*word, *wordend) and *pp past it, or 0 with *pp at end if
+ * only blanks and comments are left.  Unless eof, the word may go on past
+ * end: then -1 is returned with *pp at its start, to carry on from once
+ * there is more.  *comment says that a comment is being skipped, across
+ * calls.  *cont is set if the word has line continuations to take out.
+ */
+static int next_file_word(const char **pp, const char *end, int eof,
+			  int *comment, const char **word,
+			  const char **wordend, int *cont)
+{
+	const char *p = *pp;
+	int in_quote = 0;
+
+	for (;;) {
+		if (*comment) {
+			const char *nl = memchr(p, '\n', end - p);
+
+			if (!nl) {
+				*pp = end;
+				return 0;
+			}
+			*comment = 0;
+			p = nl + 1;
+		}
+		p = skip_spaces_view(p, end);
+		if (p == end) {
+			*pp = p;
+			return 0;
+		}
+		if (*p == '#')
+			*comment = 1;
+		else if (*p == '\\' && p + 1 < end && p[1] == '\n')
+			p += 2;
+		else
+			break;
+	}
+
+	*word = p;
+	*cont = 0;
+	for (;; p++) {
+		/* Most bytes are none of these. */
+		while (p < end && !file_special[(unsigned char)*p])
+			p++;
+		if (p == end)
+			break;
+		if (*p == '\\') {
+			if (p + 1 < end && p[1] == '\n') {
+				*cont = 1;
+				p++;
+			}
+		} else if (*p == '"')
+			in_quote = !in_quote;
+		else if (!in_quote)
+			break;
+	}
+	if (p == end && !eof) {
+		*pp = *word;
+		return -1;
+	}
+	*wordend = p;
+	*pp = p;
+	return 1;
+}
+
+/* Copy [src, end) to dst without its line continuations; dst may be src. */
+static char *join_lines(char *dst, const char *src, const char *end)
+{
+	for (; src < end; src++) {
+		if (*src == '\\' && src + 1 < end && src[1] == '\n')
+			src++;
+		else
+			*dst++ = *src;
+	}
+	return dst;
+}
+
+static int parse_file_word(const char *word,
+			   const char *wordend,
+			   struct param_info *params,
+			   int num,
+			   const struct param_index *index,
+			   param_unknown_view_fn unknown)
+{
+	const char *param, *val;
+	size_t namelen, vallen;
+	int ret;
+
+	next_arg_view(word, wordend, &param, &namelen, &val, &vallen);
+	ret = parse_one_view(param, namelen, val, vallen, params, num, index,
+			     unknown);
+	if (ret) {
+		printk("'%.*s' rejected for parameter '%.*s'\n",
+		       (int)vallen, val ? val : "", (int)namelen, param);
+	}
 	return ret;
 }
 
 /*
-    strict_strtoul converts a string to an unsigned long only if 
-    the string is really an unsigned long string, 
-    any string containing any invalid char at the tail will be 
-    rejected and -EINVAL is returned, only a newline char at the tail 
-    is acceptible because people generally
+ * A whole parameter file in memory, which is only read.  Words are held
+ * to the length the stream reader can buffer, so that a file parses the
+ * same whichever way it is read.
+ */
+static int __parse_args_map(struct param_info *params,
+        int num,
+        const struct param_index *index,
+        const char *buf,
+        size_t len,
+        param_unknown_view_fn unknown)
+{
+	const char *end = buf + len;
+	const char *word, *wordend;
+	int comment = 0, cont, ret = 0;
+
+	while (next_file_word(&buf, end, 1, &comment, &word, &wordend,
+			      &cont) > 0) {
+		char *copy = NULL;
+
+		if (wordend - word >= PARAM_FILE_CHUNK) {
+			printk("Parameter longer than %d bytes\n", PARAM_FILE_CHUNK);
+			ret = -E2BIG;
+			break;
+		}
+		/* Only a word joined from several lines is copied. */
+		if (cont) {
+			copy = malloc(wordend - word);
+			if (!copy) {
+				ret = -ENOMEM;
+				break;
+			}
+			wordend = join_lines(copy, word, wordend);
+			word = copy;
+		}
+		ret = parse_file_word(word, wordend, params, num, index,
+				      unknown);
+		free(copy);
+		if (ret)
+			break;
+	}
+	return ret;
+}
+
+/*
+ * A parameter file read from fd a buffer at a time.  The words finished
+ * in the buffer are parsed where they lie, and the start of an unfinished
+ * one moves to the front of the buffer to be read on to.
+ */
+static int __parse_args_stream(struct param_info *params,
+        int num,
+        const struct param_index *index,
+        int fd,
+        param_unknown_view_fn unknown)
+{
+	char *buf = malloc(PARAM_FILE_CHUNK);
+	const char *p, *end, *word, *wordend;
+	size_t have = 0;
+	int comment = 0, partial = 0, eof = 0, cont, ret = 0;
+
+	if (!buf)
+		return -ENOMEM;
+	for (;;) {
+		long n = read(fd, buf + have, PARAM_FILE_CHUNK - have);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			ret = -errno;
+			break;
+		}
+		have += n;
+		eof = n == 0;
+		/*
+		 * Scan an unfinished word again only once the buffer is full,
+		 * so that no byte is scanned more than twice.
+		 */
+		if (partial && have < PARAM_FILE_CHUNK && !eof)
+			continue;
+
+		p = buf;
+		end = buf + have;
+		while (next_file_word(&p, end, eof, &comment, &word, &wordend,
+				      &cont) > 0) {
+			if (cont)
+				wordend = join_lines((char *)word, word, wordend);
+			ret = parse_file_word(word, wordend, params, num, index,
+					      unknown);
+			if (ret)
+				break;
+		}
+		if (ret || eof)
+			break;
+
+		have = end - p;
+		if (have == PARAM_FILE_CHUNK) {
+			printk("Parameter longer than %d bytes\n", PARAM_FILE_CHUNK);
+			ret = -E2BIG;
+			break;
+		}
+		memmove(buf, p, have);
+		partial = have > 0;
+	}
+	free(buf);
+	return ret;
+}
+
+int parse_args_stream(struct param_info *params,
+        int num,
+        int fd,
+        param_unknown_view_fn unknown)
+{
+	struct call_index ci;
+	struct param_index *index;
+	int ret;
+
+	GETOPT_PROBE2(moduleparam, parse_args__entry, num, 1);
+	index = call_index_get(&ci, params, num);
+	ret = __parse_args_stream(params, num, index, fd, unknown);
+	call_index_put(&ci, index);
+	GETOPT_PROBE1(moduleparam, parse_args__return, ret);
+	return ret;
+}
+
+int parse_args_fd(struct param_info *params,
+        int num,
+        int fd,
+        param_unknown_view_fn unknown)
+{
+#ifndef WIN32
+	struct call_index ci;
+	struct param_index *index;
+	struct stat st;
+	off_t off;
+	void *map;
+	int ret;
+
+	/* Regular files are mapped and parsed without a copy. */
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)
+	    || (unsigned long long)st.st_size > SIZE_MAX)
+		return parse_args_stream(params, num, fd, unknown);
+	off = lseek(fd, 0, SEEK_CUR);
+	if (off < 0 || off >= st.st_size)
+		return parse_args_stream(params, num, fd, unknown);
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		return parse_args_stream(params, num, fd, unknown);
+# ifdef POSIX_MADV_SEQUENTIAL
+	posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+# endif
+
+	GETOPT_PROBE2(moduleparam, parse_args__entry, num, 1);
+	index = call_index_get(&ci, params, num);
+	ret = __parse_args_map(params, num, index, (const char *)map + off,
+			       (size_t)(st.st_size - off), unknown);
+	call_index_put(&ci, index);
+	munmap(map, (size_t)st.st_size);
+	/* Leave fd where reading it would have. */
+	lseek(fd, 0, SEEK_END);
+	GETOPT_PROBE1(moduleparam, parse_args__return, ret);
+	return ret;
+#else
+	return parse_args_stream(params, num, fd, unknown);
+#endif
+}
+
+int parse_args_file(struct param_info *params,
+        int num,
+        const char *path,
+        param_unknown_view_fn unknown)
+{
+	int fd, ret;
+
+	do
+		fd = open(path, O_RDONLY);
+	while (fd < 0 && errno == EINTR);
+	if (fd < 0)
+		return -errno;
+	ret = parse_args_fd(params, num, fd, unknown);
+	close(fd);
+	return ret;
+}
+
+/*
+    strict_strntoul converts the len bytes at cp to an unsigned long only
+    if they are really an unsigned long string, as strtoul would read it:
+    any invalid char at the tail is rejected and -EINVAL is returned,
+    only a newline char at the tail is acceptible because people
+    generally write one.  Nothing past cp + len is read.
 */
-int strict_strtoul(const char *cp, unsigned int base, unsigned long *res)
+int strict_strntoul(const char *cp, size_t len, unsigned int base,
+		    unsigned long *res)
 {
-    char *tail;
-    unsigned long val;
-    size_t len;
+    size_t i = 0, digits;
+    unsigned long val = 0;
+    int neg = 0, overflow = 0;
 
     *res = 0;
-    len = strlen(cp);
     if (len == 0)
         return -EINVAL;
 
-    val = strtoul(cp, &tail, base);
-    if (tail == cp)
+    while (i < len && isspace((unsigned char)cp[i]))
+        i++;
+    if (i < len && (cp[i] == '+' || cp[i] == '-'))
+        neg = cp[i++] == '-';
+    if ((base == 0 || base == 16) && i + 2 < len && cp[i] == '0'
+        && (cp[i + 1] == 'x' || cp[i + 1] == 'X')
+        && isxdigit((unsigned char)cp[i + 2])) {
+        i += 2;
+        base = 16;
+    } else if (base == 0)
+        base = i < len && cp[i] == '0' ? 8 : 10;
+
+    for (digits = i; i < len; i++) {
+        unsigned int d;
+
+        if (isdigit((unsigned char)cp[i]))
+            d = cp[i] - '0';
+        else if (isalpha((unsigned char)cp[i]))
+            d = tolower((unsigned char)cp[i]) - 'a' + 10;
+        else
+            break;
+        if (d >= base)
+            break;
+        if (val > (ULONG_MAX - d) / base)
+            overflow = 1;
+        val = val * base + d;
+    }
+    if (i == digits)
         return -EINVAL;
 
-    if ((*tail == '\0') ||
-        ((len == (size_t)(tail - cp) + 1) && (*tail == '\n'))) {
-        *res = val;
+    if (i == len || (i == len - 1 && cp[i] == '\n')) {
+        *res = overflow ? ULONG_MAX : neg ? -val : val;
         return 0;
     }
-    
+
     return -EINVAL;
 }
 
-int strict_strtol(const char *cp, unsigned int base, long *res)
+int strict_strntol(const char *cp, size_t len, unsigned int base, long *res)
 {
     int ret;
-    if (*cp == '-') {
-        ret = strict_strtoul(cp + 1, base, (unsigned long *)res);
+    if (len && *cp == '-') {
+        ret = strict_strntoul(cp + 1, len - 1, base, (unsigned long *)res);
         if (!ret)
             *res = -(*res);
     } else {
-        ret = strict_strtoul(cp, base, (unsigned long *)res);
+        ret = strict_strntoul(cp, len, base, (unsigned long *)res);
     }
 
     return ret;
 }
 
+int strict_strtoul(const char *cp, unsigned int base, unsigned long *res)
+{
+    return strict_strntoul(cp, strlen(cp), base, res);
+}
+
+int strict_strtol(const char *cp, unsigned int base, long *res)
+{
+    return strict_strntol(cp, strlen(cp), base, res);
+}
+
 /* Lazy bastard, eh? */
 #define STANDARD_PARAM_DEF(name, type, format, tmptype, strtolfn)      	\
-	int param_set_##name(const char *val, struct param_info *kp)	\
+	int param_set_##name##_view(const char *val, size_t len,	\
+				    struct param_info *kp)		\
 	{								\
 		tmptype l;						\
 		int ret;						\
 									\
 		if (!val) return -EINVAL;				\
-		ret = strtolfn(val, 0, &l);				\
+		ret = strtolfn(val, len, 0, &l);			\
 		if (ret == -EINVAL || ((type)l != l))			\
 			return -EINVAL;					\
 		*((type *)kp->arg) = l;					\
 		return 0;						\
 	}								\
+	int param_set_##name(const char *val, struct param_info *kp)	\
+	{								\
+		return param_set_##name##_view(val, val ? strlen(val) : 0, kp); \
+	}								\
 	int param_get_##name(char *buffer, struct param_info *kp)	\
 	{								\
 		return sprintf(buffer, format, *((type *)kp->arg));	\
 	}
 
-STANDARD_PARAM_DEF(byte, unsigned char, "%c", unsigned long, strict_strtoul);
-STANDARD_PARAM_DEF(short, short, "%hi", long, strict_strtol);
-STANDARD_PARAM_DEF(ushort, unsigned short, "%hu", unsigned long, strict_strtoul);
-STANDARD_PARAM_DEF(int, int, "%i", long, strict_strtol);
-STANDARD_PARAM_DEF(uint, unsigned int, "%u", unsigned long, strict_strtoul);
-STANDARD_PARAM_DEF(long, long, "%li", long, strict_strtol);
-STANDARD_PARAM_DEF(ulong, unsigned long, "%lu", unsigned long, strict_strtoul);
+STANDARD_PARAM_DEF(byte, unsigned char, "%c", unsigned long, strict_strntoul);
+STANDARD_PARAM_DEF(short, short, "%hi", long, strict_strntol);
+STANDARD_PARAM_DEF(ushort, unsigned short, "%hu", unsigned long, strict_strntoul);
+STANDARD_PARAM_DEF(int, int, "%i", long, strict_strntol);
+STANDARD_PARAM_DEF(uint, unsigned int, "%u", unsigned long, strict_strntoul);
+STANDARD_PARAM_DEF(long, long, "%li", long, strict_strntol);
+STANDARD_PARAM_DEF(ulong, unsigned long, "%lu", unsigned long, strict_strntoul);
 
 /* Actually could be a bool or an int, for historical reasons. */
-int param_set_bool(const char *val, struct param_info *kp)
+int param_set_bool_view(const char *val, size_t len, struct param_info *kp)
 {
 	bool v;
 
 	/* No equals means "set"... */
-	if (!val) val = "1";
+	if (!val) {
+		val = "1";
+		len = 1;
+	}
 
 	/* One of =[yYnN01] */
-	switch (val[0]) {
+	switch (len ? val[0] : '\0') {
 	case 'y': case 'Y': case '1':
 		v = 1;
 		break;
@@ -301,6 +1239,11 @@ int param_set_bool(const char *val, struct param_info *kp)
 	return 0;
 }
 
+int param_set_bool(const char *val, struct param_info *kp)
+{
+	return param_set_bool_view(val, val ? strlen(val) : 0, kp);
+}
+
 int param_get_bool(char *buffer, struct param_info *kp)
 {
 	bool val;
@@ -314,7 +1257,7 @@ int param_get_bool(char *buffer, struct param_info *kp)
 }
 
 /* This one must be bool. */
-int param_set_invbool(const char *val, struct param_info *kp)
+int param_set_invbool_view(const char *val, size_t len, struct param_info *kp)
 {
 	int ret;
 	bool boolval;
@@ -322,20 +1265,29 @@ int param_set_invbool(const char *val, struct param_info *kp)
 
 	dummy.arg = &boolval;
 	dummy.flags = PARAM_ISBOOL;
-	ret = param_set_bool(val, &dummy);
+	ret = param_set_bool_view(val, len, &dummy);
 	if (ret == 0)
 		*(bool *)kp->arg = !boolval;
 	return ret;
 }
 
+int param_set_invbool(const char *val, struct param_info *kp)
+{
+	return param_set_invbool_view(val, val ? strlen(val) : 0, kp);
+}
+
 int param_get_invbool(char *buffer, struct param_info *kp)
 {
 	return sprintf(buffer, "%c", (*(bool *)kp->arg) ? 'N' : 'Y');
 }
 
-/* We break the rule and mangle the string. */
+/*
+ * A comma-separated list of len bytes at val.  Elements go to the view
+ * setter of set where there is one; for any other setter each is copied
+ * out to get its own NUL, as val is not ours to write to.
+ */
 static int param_array(const char *name,
-		       const char *val,
+		       const char *val, size_t vallen,
 		       unsigned int min, unsigned int max,
 		       void *elem, int elemsize,
 		       int (*set)(const char *, struct param_info *kp),
@@ -344,7 +1296,9 @@ static int param_array(const char *name,
 {
 	int ret;
 	struct param_info kp;
-	char save;
+	param_set_view_fn set_view = param_view_setter(set);
+	const char *end = val + vallen;
+	char buf[64], *elt;
 
 	/* Get the name right for errors. */
 	kp.name = name;
@@ -359,27 +1313,42 @@ static int param_array(const char *name,
 
 	*num = 0;
 	/* We expect a comma-separated list of values. */
-	do {
-		int len;
+	for (;;) {
+		const char *comma;
+		size_t len;
 
 		if (*num == max) {
 			printk("%s: can only take %i arguments\n",
 			       name, max);
 			return -EINVAL;
 		}
-		len = strcspn(val, ",");
-
-		/* nul-terminate and parse */
-		save = val[len];
-		((char *)val)[len] = '\0';
-		ret = set(val, &kp);
+		comma = memchr(val, ',', end - val);
+		len = (comma ? comma : end) - val;
+
+		if (set_view)
+			ret = set_view(val, len, &kp);
+		else {
+			elt = buf;
+			if (len >= sizeof(buf)) {
+				elt = malloc(len + 1);
+				if (!elt)
+					return -ENOMEM;
+			}
+			memcpy(elt, val, len);
+			elt[len] = '\0';
+			ret = set(elt, &kp);
+			if (elt != buf)
+				free(elt);
+		}
 
 		if (ret != 0)
 			return ret;
 		kp.arg = (char *)kp.arg + elemsize;
-		val += len+1;
 		(*num)++;
-	} while (save == ',');
+		if (!comma)
+			break;
+		val = comma + 1;
+	}
 
 	if (*num < min) {
 		printk("%s: needs at least %i arguments\n",
@@ -389,15 +1358,19 @@ static int param_array(const char *name,
 	return 0;
 }
 
-int param_array_set(const char *val, struct param_info *kp)
+int param_array_set_view(const char *val, size_t len, struct param_info *kp)
 {
 	const struct param_array *arr = kp->arr;
-	unsigned int temp_num;
 
-	return param_array(kp->name, val, 1, arr->max, arr->elem,
+	return param_array(kp->name, val, len, 1, arr->max, arr->elem,
 			   arr->elemsize, arr->set, kp->flags, arr->num);
 }
 
+int param_array_set(const char *val, struct param_info *kp)
+{
+	return param_array_set_view(val, val ? strlen(val) : 0, kp);
+}
+
 int param_array_get(char *buffer, struct param_info *kp)
 {
 	int i, off, ret;
@@ -418,7 +1391,8 @@ int param_array_get(char *buffer, struct param_info *kp)
 	return off;
 }
 
-int param_set_copystring(const char *val, struct param_info *kp)
+int param_set_copystring_view(const char *val, size_t len,
+			      struct param_info *kp)
 {
 	const struct param_string *kps = kp->str;
 
@@ -426,15 +1400,21 @@ int param_set_copystring(const char *val, struct param_info *kp)
 		printk("%s: missing param set value\n", kp->name);
 		return -EINVAL;
 	}
-	if (strlen(val)+1 > kps->maxlen) {
+	if (len+1 > kps->maxlen) {
 		printk("%s: string doesn't fit in %u chars.\n",
 		       kp->name, kps->maxlen-1);
 		return -ENOSPC;
 	}
-	strcpy(kps->string, val);
+	memcpy(kps->string, val, len);
+	kps->string[len] = '\0';
 	return 0;
 }
 
+int param_set_copystring(const char *val, struct param_info *kp)
+{
+	return param_set_copystring_view(val, val ? strlen(val) : 0, kp);
+}
+
 #ifndef __APPLE__
 /**
  * strlcpy - Copy a %NUL terminated string into a sized buffer
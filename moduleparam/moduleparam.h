@@ -34,6 +34,15 @@ struct param_string;
 typedef int (*param_set_fn)(const char *val, struct param_info *kp);
 /* Returns length written or -errno.  Buffer is 4k (ie. be short!) */
 typedef int (*param_get_fn)(char *buffer, struct param_info *kp);
+/*
+ * As param_set_fn, for the len bytes at val, which are not followed by a
+ * NUL and must not be written to.  val is NULL if there was no value.
+ */
+typedef int (*param_set_view_fn)(const char *val, size_t len,
+				 struct param_info *kp);
+/* Handler of unknown params given as views, for parse_args_buf. */
+typedef int (*param_unknown_view_fn)(const char *param, size_t len,
+				     const char *val, size_t vallen);
 
 /* Flag bits for param_info.flags */
 #define PARAM_ISBOOL		2
@@ -84,6 +93,49 @@ typedef int bool;
 /* Chosen so that structs with an unsigned long line up. */
 #define MAX_PARAM_PREFIX_LEN (64 - sizeof(unsigned long))
 
+#define BUILD_BUG_ON_ZERO(e) (sizeof(char[1 - 2 * !!(e)]) - 1)
+
+#ifdef MODULE_PARAM_SECTION
+/*
+ * Link-time registration, as in the kernel: each module_param* is a const
+ * param_info of its own, in any file and at file scope or in a function,
+ * which the linker gathers with the others into the section moduleparam.
+ * The params are then the array from __start_moduleparam to
+ * __stop_moduleparam, those of the executable or shared library the
+ * macros are used in, and nothing is registered at startup.
+ * init_module_param is not needed.  Define MODULE_PARAM_SECTION before
+ * including this file in every file that declares params or uses
+ * MODULE_INIT_VARIABLE.
+ */
+#if !defined(__GNUC__) || defined(__APPLE__) || defined(WIN32)
+#error "MODULE_PARAM_SECTION needs an ELF linker, which defines __start_ and __stop_ symbols"
+#endif
+
+/* Weak, for a program without any params. */
+extern __moduleparam_const struct param_info __start_moduleparam[]
+	__attribute__((weak, visibility("hidden")));
+extern __moduleparam_const struct param_info __stop_moduleparam[]
+	__attribute__((weak, visibility("hidden")));
+
+#define MODULE_INIT_VARIABLE ((struct param_info *)__start_moduleparam)
+#define MODULE_INIT_VARIABLE_NUM \
+	((int)(__stop_moduleparam - __start_moduleparam))
+
+#define init_module_param(num) do { } while (0)
+
+/* Aligned no more than a pointer, so that the section is an array. */
+#define __module_param_call(prefix, vname, vset, vget, varg, isbool)  \
+	static const char __param_str_##vname[] = prefix #vname;		\
+	static __moduleparam_const struct param_info __param_##vname	\
+	__attribute__((used, section("moduleparam"),			\
+		       aligned(sizeof(void *)))) = {			\
+		.name = __param_str_##vname,				\
+		.flags = isbool ? PARAM_ISBOOL : 0,			\
+		.set = vset,						\
+		.get = vget,						\
+		varg							\
+	}
+#else
 #define MODULE_INIT_VARIABLE __module_params
 #define MODULE_INIT_VARIABLE_INDEX __module_params_index
 #define MODULE_INIT_VARIABLE_NUM __module_params_num
@@ -94,8 +146,6 @@ typedef int bool;
     static struct param_info MODULE_INIT_VARIABLE[num];	\
     memset(&MODULE_INIT_VARIABLE, 0, sizeof(MODULE_INIT_VARIABLE))
 
-#define BUILD_BUG_ON_ZERO(e) (sizeof(char[1 - 2 * !!(e)]) - 1)
-
 /* This is the fundamental function for registering boot/module
    parameters.  perm sets the visibility in sysfs: 000 means it's
    not there, read bits mean it's readable, write bits mean it's
@@ -110,6 +160,7 @@ typedef int bool;
     MODULE_INIT_VARIABLE[MODULE_INIT_VARIABLE_INDEX].get = vget; \
     MODULE_INIT_VARIABLE[MODULE_INIT_VARIABLE_INDEX]varg; \
     ++MODULE_INIT_VARIABLE_INDEX
+#endif
 
 #define module_param_call(name, set, get, varg, isbool)     \
 	__module_param_call(MODULE_PARAM_PREFIX,			    \
@@ -139,30 +190,37 @@ typedef int bool;
 	static inline type *__check_##name(void) { return (p); }
 
 extern EXPORTS_API int param_set_byte(const char *val, struct param_info *kp);
+extern EXPORTS_API int param_set_byte_view(const char *val, size_t len, struct param_info *kp);
 extern EXPORTS_API int param_get_byte(char *buffer, struct param_info *kp);
 #define param_check_byte(name, p) __param_check(name, p, unsigned char)
 
 extern EXPORTS_API int param_set_short(const char *val, struct param_info *kp);
+extern EXPORTS_API int param_set_short_view(const char *val, size_t len, struct param_info *kp);
 extern EXPORTS_API int param_get_short(char *buffer, struct param_info *kp);
 #define param_check_short(name, p) __param_check(name, p, short)
 
 extern EXPORTS_API int param_set_ushort(const char *val, struct param_info *kp);
+extern EXPORTS_API int param_set_ushort_view(const char *val, size_t len, struct param_info *kp);
 extern EXPORTS_API int param_get_ushort(char *buffer, struct param_info *kp);
 #define param_check_ushort(name, p) __param_check(name, p, unsigned short)
 
 extern EXPORTS_API int param_set_int(const char *val, struct param_info *kp);
+extern EXPORTS_API int param_set_int_view(const char *val, size_t len, struct param_info *kp);
 extern EXPORTS_API int param_get_int(char *buffer, struct param_info *kp);
 #define param_check_int(name, p) __param_check(name, p, int)
 
 extern EXPORTS_API int param_set_uint(const char *val, struct param_info *kp);
+extern EXPORTS_API int param_set_uint_view(const char *val, size_t len, struct param_info *kp);
 extern EXPORTS_API int param_get_uint(char *buffer, struct param_info *kp);
 #define param_check_uint(name, p) __param_check(name, p, unsigned int)
 
 extern EXPORTS_API int param_set_long(const char *val, struct param_info *kp);
+extern EXPORTS_API int param_set_long_view(const char *val, size_t len, struct param_info *kp);
 extern EXPORTS_API int param_get_long(char *buffer, struct param_info *kp);
 #define param_check_long(name, p) __param_check(name, p, long)
 
 extern EXPORTS_API int param_set_ulong(const char *val, struct param_info *kp);
+extern EXPORTS_API int param_set_ulong_view(const char *val, size_t len, struct param_info *kp);
 extern EXPORTS_API int param_get_ulong(char *buffer, struct param_info *kp);
 #define param_check_ulong(name, p) __param_check(name, p, unsigned long)
 
@@ -172,6 +230,7 @@ extern EXPORTS_API int param_get_charp(char *buffer, struct param_info *kp);
 
 /* For historical reasons "bool" parameters can be (unsigned) "int". */
 extern EXPORTS_API int param_set_bool(const char *val, struct param_info *kp);
+extern EXPORTS_API int param_set_bool_view(const char *val, size_t len, struct param_info *kp);
 extern EXPORTS_API int param_get_bool(char *buffer, struct param_info *kp);
 #define param_check_bool(name, p)					\
 	static inline void __check_##name(void)				\
@@ -179,6 +238,7 @@ extern EXPORTS_API int param_get_bool(char *buffer, struct param_info *kp);
 	}
 
 extern EXPORTS_API int param_set_invbool(const char *val, struct param_info *kp);
+extern EXPORTS_API int param_set_invbool_view(const char *val, size_t len, struct param_info *kp);
 extern EXPORTS_API int param_get_invbool(char *buffer, struct param_info *kp);
 #define param_check_invbool(name, p) __param_check(name, p, bool)
 
@@ -198,20 +258,136 @@ extern EXPORTS_API int param_get_invbool(char *buffer, struct param_info *kp);
 	module_param_array_named(name, name, type, nump)
 
 extern EXPORTS_API int param_array_set(const char *val, struct param_info *kp);
+extern EXPORTS_API int param_array_set_view(const char *val, size_t len, struct param_info *kp);
 extern EXPORTS_API int param_array_get(char *buffer, struct param_info *kp);
 
 extern EXPORTS_API int param_set_copystring(const char *val, struct param_info *kp);
+extern EXPORTS_API int param_set_copystring_view(const char *val, size_t len, struct param_info *kp);
 extern EXPORTS_API int param_get_string(char *buffer, struct param_info *kp);
 
+/* How a parameter is set, as written to a getopt recording: the kind
+   of an array is PARAM_KIND_ARRAY or'ed with the kind of its elements. */
+enum param_kind {
+	PARAM_KIND_OTHER,
+	PARAM_KIND_BYTE,
+	PARAM_KIND_SHORT,
+	PARAM_KIND_USHORT,
+	PARAM_KIND_INT,
+	PARAM_KIND_UINT,
+	PARAM_KIND_LONG,
+	PARAM_KIND_ULONG,
+	PARAM_KIND_BOOL,
+	PARAM_KIND_INVBOOL,
+	PARAM_KIND_COPYSTRING,
+	PARAM_KIND_ARRAY = 0x100
+};
+
+/* Flags of a GETOPT_RECORD_PARSE_ARGS. */
+#define PARSE_ARGS_RECORD_UNKNOWN	0x1	/* With an unknown handler. */
+#define PARSE_ARGS_RECORD_STRING	0x2	/* From parse_args_string. */
+#define PARSE_ARGS_RECORD_BUF		0x4	/* From parse_args_buf. */
+
+/* Returns the param_set_* for a kind, or NULL for PARAM_KIND_OTHER. */
+extern EXPORTS_API param_set_fn param_kind_set(int kind);
+
+/*
+ * Sets params from argv[1..argc), each element one "name=value" or
+ * "name", as the shell left it: the value is taken literally.  argv is
+ * not written to.  unknown, if not NULL, is called for names of no
+ * param, with a name that is only valid during the call.
+ */
 extern EXPORTS_API int parse_args(struct param_info *params,
         int num,
         int argc,
         char **argv,
         int (*unknown)(char *param, char *val));
 
+/*
+ * Sets params from one string, "foo=bar,bar2 baz=fuz wiz", split at
+ * spaces outside double quotes; the quotes around a value (or around a
+ * whole "foo=bar baz") are removed.  args is cut up in place.
+ */
+extern EXPORTS_API int parse_args_string(struct param_info *params,
+        int num,
+        char *args,
+        int (*unknown)(char *param, char *val));
+
+/*
+ * parse_args_string for the len bytes at buf, which are only read: buf
+ * may be mapped read-only or shared between threads.  Values go to the
+ * params as views, to the _view setter of each param_set_* without a
+ * copy; a setter of another kind gets a NUL-terminated copy.
+ */
+extern EXPORTS_API int parse_args_buf(struct param_info *params,
+        int num,
+        const char *buf,
+        size_t len,
+        param_unknown_view_fn unknown);
+
+/*
+ * Parameter files, such as "foo=bar,bar2 baz=fuz wiz" over any number of
+ * lines, in which a '#' starting a word comments out the rest of its
+ * line and a backslash ending a line continues it on the next.
+ * parse_args_file and parse_args_fd map a regular file and parse it in
+ * place; pipes, terminals and the like are read by parse_args_stream
+ * PARAM_FILE_CHUNK bytes at a time, which bounds the memory used.  Either
+ * way a word, with its continuations, must be shorter than
+ * PARAM_FILE_CHUNK bytes, or -E2BIG is returned.  Returns 0, -errno if
+ * the file cannot be read, or the error of the first param rejected, as
+ * parse_args_buf.  Files are not written to a getopt recording, being of
+ * any size.
+ */
+#define PARAM_FILE_CHUNK 65536
+
+extern EXPORTS_API int parse_args_file(struct param_info *params,
+        int num,
+        const char *path,
+        param_unknown_view_fn unknown);
+/* From the current offset of fd to its end. */
+extern EXPORTS_API int parse_args_fd(struct param_info *params,
+        int num,
+        int fd,
+        param_unknown_view_fn unknown);
+extern EXPORTS_API int parse_args_stream(struct param_info *params,
+        int num,
+        int fd,
+        param_unknown_view_fn unknown);
+
 #define parse_params(argc, argv, func)      \
     parse_args(MODULE_INIT_VARIABLE, MODULE_INIT_VARIABLE_NUM, argc, argv, func)
 
+/*
+ * A hash index over the names of params, so that each lookup costs the
+ * length of the name rather than a comparison with every param.
+ * parse_args builds one for the call when there are PARAM_INDEX_MIN
+ * params or more.  For up to 512 params it is on the stack and nothing
+ * is allocated; for more, every call allocates and frees it.  A caller
+ * with that many params, or that parses many times against the same
+ * ones, should build the index once with param_index_new and parse with
+ * parse_args_indexed or parse_args_buf_indexed, which allocate nothing.
+ * params must outlive the index and keep their names.  NULL if out of
+ * memory.
+ */
+#define PARAM_INDEX_MIN 16
+
+struct param_index;
+
+extern EXPORTS_API struct param_index *param_index_new(struct param_info *params,
+        int num);
+extern EXPORTS_API void param_index_free(struct param_index *index);
+/* The first param named name, with '-' read as '_', or NULL. */
+extern EXPORTS_API struct param_info *param_index_find(const struct param_index *index,
+        const char *name);
+
+extern EXPORTS_API int parse_args_indexed(struct param_index *index,
+        int argc,
+        char **argv,
+        int (*unknown)(char *param, char *val));
+extern EXPORTS_API int parse_args_buf_indexed(struct param_index *index,
+        const char *buf,
+        size_t len,
+        param_unknown_view_fn unknown);
+
 #ifdef __cplusplus
 }
 #endif
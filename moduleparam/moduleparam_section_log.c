@@ -0,0 +1,18 @@
+// the logging half of moduleparam_section_test: its params are declared
+// here, next to the code that reads them, and the linker registers them
+// with those of the other file
+#define MODULE_PARAM_SECTION
+#include "moduleparam.h"
+#include <stdio.h>
+
+static int log_level = 1;
+static bool log_prefix = 0;
+
+module_param(log_level, int);
+module_param_bool(log_prefix);
+
+void log_print(int level, const char *msg)
+{
+    if (level <= log_level)
+        printf("%s%s\n", log_prefix ? "moduleparam_section_test: " : "", msg);
+}
@@ -0,0 +1,49 @@
+// moduleparam_test with link-time registration: the params of both files
+// are found in the moduleparam section, without init_module_param
+#define MODULE_PARAM_SECTION
+#include "moduleparam.h"
+#include <stdio.h>
+
+static int test = 0;
+static unsigned int latest_num = 0;
+static long latest[10] = {0};
+static char strtest[20] = "\0";
+
+module_param(test, int);
+module_param_array(latest, long, &latest_num);
+module_param_string(strtest, strtest, sizeof(strtest));
+
+void log_print(int level, const char *msg);
+
+void usage()
+{
+    printf("usage: moduleparam_section_test [test=int] [latest=int array] [strtest=string]\n"
+           "                                [log_level=int] [log_prefix[=bool]]\n");
+}
+
+int unknown_handler(char *param, char *val)
+{
+    printf("find unknown param: %s\n", param);
+    return 0;
+}
+
+int main (int argc, char **argv)
+{
+    int ret = parse_params(argc, argv, unknown_handler);
+
+    if(ret != 0)
+    {
+        usage();
+        return 0;
+    }
+
+    char buf[1024];
+    for(int i=0; i < MODULE_INIT_VARIABLE_NUM; ++i)
+    {
+        MODULE_INIT_VARIABLE[i].get(buf, &MODULE_INIT_VARIABLE[i]);
+        printf("%s = %s\n", MODULE_INIT_VARIABLE[i].name, buf);
+    }
+    log_print(1, "parsed");
+    log_print(2, "parsed, in detail");
+    return 0;
+}
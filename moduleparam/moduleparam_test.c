@@ -1,4 +1,5 @@
 #include "moduleparam.h"
+#include <getopt.h>
 #include <stdio.h>
 
 static int test = 0;
@@ -7,6 +8,10 @@ static unsigned int latest_num = 0;
 static long latest[10] = {0};
 static char strtest[20] = "\0";
 
+// the names of the params above, for suggestions
+static struct getopt_nameindex *param_names = 0;
+static struct param_info *params = 0;
+
 void usage()
 {
     char *msg = "usage: moduleparam_test [test=int] [btest[=bool]] [latest=int array] [strtest=string]\n";
@@ -15,7 +20,25 @@ void usage()
 
 int unknown_handler(char *param, char *val)
 {
+    char name[64];
+    int nearest[GETOPT_MAX_SUGGESTIONS];
+    size_t len;
+    int i, n;
+
     printf("find unknown param: %s\n", param);
+    if (!param_names)
+        return 0;
+
+    // params are looked up with dashes and underscores alike
+    for (len = 0; param[len] && len < sizeof(name); ++len)
+        name[len] = param[len] == '-' ? '_' : param[len];
+
+    n = getopt_nameindex_nearest(param_names, name, len, len < 4 ? 1 : 2,
+                                 nearest, GETOPT_MAX_SUGGESTIONS);
+    for (i = 0; i < n; ++i)
+        printf("%s %s", i ? "," : "did you mean", params[nearest[i]].name);
+    if (n)
+        printf("?\n");
     return 0;
 }
 
@@ -27,7 +50,15 @@ int main (int argc, char **argv)
     module_param_array(latest, long, &latest_num);
     module_param_string(strtest, strtest, sizeof(strtest));
 
+    // the index only keeps pointers to the names
+    params = MODULE_INIT_VARIABLE;
+    param_names = getopt_nameindex_new(&MODULE_INIT_VARIABLE[0].name,
+                                       MODULE_INIT_VARIABLE_NUM,
+                                       sizeof(struct param_info));
+
     int ret = parse_params(argc, argv, unknown_handler);
+    getopt_nameindex_free(param_names);
+    param_names = 0;
 
     if(ret != 0)
     {